@@ -559,8 +559,203 @@ static int compare_section(const void *a, const void *b)
 		return -1;
 }
 
+/* unlock/erase as requested, then program one run of a flash bank */
+static int flash_write_run(struct target *target, struct flash_bank *c,
+	uint8_t *buffer, uint32_t run_address, uint32_t run_size,
+	int erase, bool unlock)
+{
+	int retval = ERROR_OK;
+
+	if (unlock)
+		retval = flash_unlock_address_range(target, run_address, run_size);
+	if (retval == ERROR_OK) {
+		if (erase) {
+			/* calculate and erase sectors */
+			retval = flash_erase_address_range(target,
+					true, run_address, run_size);
+		}
+	}
+
+	if (retval == ERROR_OK) {
+		/* write flash sectors */
+		retval = flash_driver_write(c, buffer, run_address - c->base, run_size);
+	}
+
+	return retval;
+}
+
+/* Differential variant of flash_write_run(): every sector touched by the run
+ * is compared against the flash contents first, and only consecutive groups
+ * of sectors that differ are unlocked, erased and programmed.  They are
+ * always erased, programming changed data over the old contents would
+ * corrupt it.
+ */
+static int flash_write_run_diff(struct target *target, struct flash_bank *c,
+	uint8_t *buffer, uint32_t run_address, uint32_t run_size,
+	bool unlock, uint32_t *programmed)
+{
+	uint32_t offset = 0;
+	uint32_t pending_offset = 0;
+	uint32_t pending_size = 0;
+	int sector = 0;
+	int retval;
+
+	*programmed = 0;
+
+	while (offset <= run_size) {
+		uint32_t chunk = 0;
+		bool same = false;
+
+		if (offset < run_size) {
+			uint32_t bank_offset = run_address - c->base + offset;
+
+			/* clip the chunk at the end of the sector it starts in */
+			chunk = run_size - offset;
+			for (; sector < c->num_sectors; sector++) {
+				uint32_t end = c->sectors[sector].offset + c->sectors[sector].size;
+				if (bank_offset < end) {
+					if (chunk > end - bank_offset)
+						chunk = end - bank_offset;
+					break;
+				}
+			}
+
+			uint32_t image_crc, flash_crc;
+			if ((image_calculate_checksum(buffer + offset, chunk, &image_crc) == ERROR_OK) &&
+				(target_checksum_memory(target, run_address + offset, chunk,
+						&flash_crc) == ERROR_OK))
+				same = (image_crc == flash_crc);
+
+			if (!same) {
+				if (pending_size == 0)
+					pending_offset = offset;
+				pending_size += chunk;
+				offset += chunk;
+				continue;
+			}
+
+			LOG_DEBUG("flash at 0x%8.8" PRIx32 " (%" PRIu32 " bytes) unchanged",
+				run_address + offset, chunk);
+		}
+
+		/* an unchanged chunk or the end of the run flushes pending changes */
+		if (pending_size) {
+			retval = flash_write_run(target, c, buffer + pending_offset,
+					run_address + pending_offset, pending_size, true, unlock);
+			if (retval != ERROR_OK)
+				return retval;
+			*programmed += pending_size;
+			pending_size = 0;
+		}
+
+		if (offset == run_size)
+			break;
+		offset += chunk;
+	}
+
+	return ERROR_OK;
+}
+
+/* a flash run is read from the image and programmed in windows of about
+ * this many bytes, extended to the end of the sector they stop in */
+#define FLASH_WRITE_WINDOW_SIZE	(1024 * 1024)
+
+/* Return the size of the window of a run starting at bank offset start:
+ * at most FLASH_WRITE_WINDOW_SIZE, unless a single sector is larger, and
+ * ending on a sector boundary so no sector is erased twice.
+ */
+static uint32_t flash_write_window(struct flash_bank *c, uint32_t start,
+	uint32_t remaining)
+{
+	uint32_t size = remaining;
+
+	if (size <= FLASH_WRITE_WINDOW_SIZE)
+		return size;
+	size = FLASH_WRITE_WINDOW_SIZE;
+
+	for (int sector = 0; sector < c->num_sectors; sector++) {
+		uint32_t end = c->sectors[sector].offset + c->sectors[sector].size;
+		if (start + size <= end) {
+			size = end - start;
+			break;
+		}
+	}
+
+	return size > remaining ? remaining : size;
+}
+
+/* Fill buffer with the next size bytes of a run: the data of the sorted
+ * sections starting at *section / *section_offset, each followed by the
+ * padding recorded for it.
+ */
+static int flash_write_fill(struct image *image, struct imagesection **sections,
+	int *padding, int *section, uint32_t *section_offset, uint8_t pad_value,
+	uint8_t *buffer, uint32_t size)
+{
+	uint32_t filled = 0;
+	int retval;
+
+	while (filled < size) {
+		if (*section >= image->num_sections)
+			return ERROR_FAIL;
+
+		if (*section_offset < sections[*section]->size) {
+			size_t size_read = size - filled;
+			if (size_read > sections[*section]->size - *section_offset)
+				size_read = sections[*section]->size - *section_offset;
+
+			/* KLUDGE!
+			 *
+			 * #¤%#"%¤% we have to figure out the section # from the sorted
+			 * list of pointers to sections to invoke image_read_section()...
+			 */
+			intptr_t diff = (intptr_t)sections[*section] - (intptr_t)image->sections;
+			int t_section_num = diff / sizeof(struct imagesection);
+
+			LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, "
+					"section_offset = %d, buffer_size = %d, size_read = %d",
+				*section, t_section_num, (int)*section_offset,
+				(int)filled, (int)size_read);
+			retval = image_read_section(image, t_section_num, *section_offset,
+					size_read, buffer + filled, &size_read);
+			if (retval != ERROR_OK)
+				return retval;
+			if (size_read == 0)
+				return ERROR_FAIL;
+
+			filled += size_read;
+			*section_offset += size_read;
+			continue;
+		}
+
+		/* see if we need to pad the section */
+		if (padding[*section] > 0) {
+			uint32_t pad = size - filled;
+			if (pad > (uint32_t)padding[*section])
+				pad = padding[*section];
+			memset(buffer + filled, pad_value, pad);
+			padding[*section] -= pad;
+			filled += pad;
+			continue;
+		}
+
+		(*section)++;
+		*section_offset = 0;
+	}
+
+	/* step past a section that is complete, the next run starts after it */
+	if (*section < image->num_sections &&
+			*section_offset >= sections[*section]->size &&
+			padding[*section] <= 0) {
+		(*section)++;
+		*section_offset = 0;
+	}
+
+	return ERROR_OK;
+}
+
 int flash_write_unlock(struct target *target, struct image *image,
-	uint32_t *written, int erase, bool unlock)
+	uint32_t *written, int erase, bool unlock, bool skip_unchanged)
 {
 	int retval = ERROR_OK;
 
@@ -598,7 +793,6 @@ int flash_write_unlock(struct target *target, struct image *image,
 
 	/* loop until we reach end of the image */
 	while (section < image->num_sections) {
-		uint32_t buffer_size;
 		uint8_t *buffer;
 		int section_last;
 		uint32_t run_address = sections[section]->base_address + section_offset;
@@ -676,7 +870,7 @@ int flash_write_unlock(struct target *target, struct image *image,
 		/* If we're applying any sector automagic, then pad this
 		 * (maybe-combined) segment to the end of its last sector.
 		 */
-		if (unlock || erase) {
+		if (unlock || erase || skip_unchanged) {
 			int sector;
 			uint32_t offset_start = run_address - c->base;
 			uint32_t offset_end = offset_start + run_size;
@@ -694,81 +888,54 @@ int flash_write_unlock(struct target *target, struct image *image,
 			run_size += delta;
 		}
 
-		/* allocate buffer */
-		buffer = malloc(run_size);
-		if (buffer == NULL) {
-			LOG_ERROR("Out of memory for flash bank buffer");
-			retval = ERROR_FAIL;
-			goto done;
-		}
-		buffer_size = 0;
-
-		/* read sections to the buffer */
-		while (buffer_size < run_size) {
-			size_t size_read;
-
-			size_read = run_size - buffer_size;
-			if (size_read > sections[section]->size - section_offset)
-				size_read = sections[section]->size - section_offset;
-
-			/* KLUDGE!
-			 *
-			 * #¤%#"%¤% we have to figure out the section # from the sorted
-			 * list of pointers to sections to invoke image_read_section()...
-			 */
-			intptr_t diff = (intptr_t)sections[section] - (intptr_t)image->sections;
-			int t_section_num = diff / sizeof(struct imagesection);
-
-			LOG_DEBUG("image_read_section: section = %d, t_section_num = %d, "
-					"section_offset = %d, buffer_size = %d, size_read = %d",
-				(int)section, (int)t_section_num, (int)section_offset,
-				(int)buffer_size, (int)size_read);
-			retval = image_read_section(image, t_section_num, section_offset,
-					size_read, buffer + buffer_size, &size_read);
-			if (retval != ERROR_OK || size_read == 0) {
-				free(buffer);
+		/* read and program the run in sector aligned windows, so a
+		 * large image never has to be held in memory as a whole */
+		uint32_t programmed = 0;
+		uint32_t run_offset = 0;
+
+		while (run_offset < run_size) {
+			uint32_t window_address = run_address + run_offset;
+			uint32_t window_size = flash_write_window(c, window_address - c->base,
+					run_size - run_offset);
+			uint32_t window_programmed = window_size;
+
+			buffer = malloc(window_size);
+			if (buffer == NULL) {
+				LOG_ERROR("Out of memory for flash bank buffer");
+				retval = ERROR_FAIL;
 				goto done;
 			}
 
-			/* see if we need to pad the section */
-			while (padding[section]--)
-				(buffer + buffer_size)[size_read++] = c->default_padded_value;
-
-			buffer_size += size_read;
-			section_offset += size_read;
-
-			if (section_offset >= sections[section]->size) {
-				section++;
-				section_offset = 0;
+			retval = flash_write_fill(image, sections, padding, &section,
+					&section_offset, c->default_padded_value, buffer, window_size);
+			if (retval == ERROR_OK) {
+				if (skip_unchanged)
+					retval = flash_write_run_diff(target, c, buffer,
+							window_address, window_size, unlock,
+							&window_programmed);
+				else
+					retval = flash_write_run(target, c, buffer,
+							window_address, window_size, erase, unlock);
 			}
-		}
 
-		retval = ERROR_OK;
+			free(buffer);
 
-		if (unlock)
-			retval = flash_unlock_address_range(target, run_address, run_size);
-		if (retval == ERROR_OK) {
-			if (erase) {
-				/* calculate and erase sectors */
-				retval = flash_erase_address_range(target,
-						true, run_address, run_size);
+			if (retval != ERROR_OK) {
+				/* abort operation */
+				goto done;
 			}
-		}
 
-		if (retval == ERROR_OK) {
-			/* write flash sectors */
-			retval = flash_driver_write(c, buffer, run_address - c->base, run_size);
+			programmed += window_programmed;
+			run_offset += window_size;
+			keep_alive();
 		}
 
-		free(buffer);
-
-		if (retval != ERROR_OK) {
-			/* abort operation */
-			goto done;
-		}
+		if (skip_unchanged && programmed < run_size)
+			LOG_INFO("skipped %" PRIu32 " unchanged bytes at 0x%8.8" PRIx32,
+				run_size - programmed, run_address);
 
 		if (written != NULL)
-			*written += run_size;	/* add run size to total written counter */
+			*written += programmed;	/* add programmed size to total written counter */
 	}
 
 done:
@@ -781,7 +948,7 @@ done:
 int flash_write(struct target *target, struct image *image,
 	uint32_t *written, int erase)
 {
-	return flash_write_unlock(target, image, written, erase, false);
+	return flash_write_unlock(target, image, written, erase, false, false);
 }
 
 struct flash_sector *alloc_block_array(uint32_t offset, uint32_t size, int num_blocks)
@@ -401,6 +401,7 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	/* flash auto-erase is disabled by default*/
 	int auto_erase = 0;
 	bool auto_unlock = false;
+	bool diff = false;
 
 	while (CMD_ARGC) {
 		if (strcmp(CMD_ARGV[0], "erase") == 0) {
@@ -413,6 +414,11 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 			CMD_ARGV++;
 			CMD_ARGC--;
 			command_print(CMD_CTX, "auto unlock enabled");
+		} else if (strcmp(CMD_ARGV[0], "diff") == 0) {
+			diff = true;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "only changed sectors will be programmed");
 		} else
 			break;
 	}
@@ -442,7 +448,7 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	if (retval != ERROR_OK)
 		return retval;
 
-	retval = flash_write_unlock(target, &image, &written, auto_erase, auto_unlock);
+	retval = flash_write_unlock(target, &image, &written, auto_erase, auto_unlock, diff);
 	if (retval != ERROR_OK) {
 		image_close(&image);
 		return retval;
@@ -459,6 +465,87 @@ COMMAND_HANDLER(handle_flash_write_image_command)
 	return retval;
 }
 
+COMMAND_HANDLER(handle_flash_write_image_gang_command)
+{
+	struct image image;
+	int retval;
+	int auto_erase = 0;
+	bool auto_unlock = false;
+
+	while (CMD_ARGC) {
+		if (strcmp(CMD_ARGV[0], "erase") == 0) {
+			auto_erase = 1;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "auto erase enabled");
+		} else if (strcmp(CMD_ARGV[0], "unlock") == 0) {
+			auto_unlock = true;
+			CMD_ARGV++;
+			CMD_ARGC--;
+			command_print(CMD_CTX, "auto unlock enabled");
+		} else
+			break;
+	}
+
+	if (CMD_ARGC < 2 || CMD_ARGC > 4)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC >= 3) {
+		image.base_address_set = 1;
+		COMMAND_PARSE_NUMBER(llong, CMD_ARGV[2], image.base_address);
+	} else {
+		image.base_address_set = 0;
+		image.base_address = 0x0;
+	}
+
+	image.start_address_set = 0;
+
+	/* parse the image once, every target is programmed from it */
+	retval = image_open(&image, CMD_ARGV[1], (CMD_ARGC == 4) ? CMD_ARGV[3] : NULL);
+	if (retval != ERROR_OK)
+		return retval;
+
+	char *targets = strdup(CMD_ARGV[0]);
+	if (targets == NULL) {
+		image_close(&image);
+		return ERROR_FAIL;
+	}
+
+	unsigned programmed = 0, failed = 0;
+	for (char *name = strtok(targets, " \t"); name; name = strtok(NULL, " \t")) {
+		struct target *target = get_target(name);
+		uint32_t written;
+		struct duration bench;
+
+		if (target == NULL) {
+			command_print(CMD_CTX, "%s: FAIL (no such target)", name);
+			failed++;
+			continue;
+		}
+
+		duration_start(&bench);
+		retval = flash_write_unlock(target, &image, &written, auto_erase, auto_unlock, false);
+		if (retval != ERROR_OK || duration_measure(&bench) != ERROR_OK) {
+			command_print(CMD_CTX, "%s: FAIL (error %d)", name, retval);
+			failed++;
+			continue;
+		}
+
+		command_print(CMD_CTX, "%s: OK, wrote %" PRIu32 " bytes "
+			"in %fs (%0.3f KiB/s)", name, written,
+			duration_elapsed(&bench), duration_kbps(&bench, written));
+		programmed++;
+	}
+
+	free(targets);
+	image_close(&image);
+
+	command_print(CMD_CTX, "programmed %u of %u targets from file %s",
+		programmed, programmed + failed, CMD_ARGV[1]);
+
+	return failed ? ERROR_FAIL : ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_flash_fill_command)
 {
 	int err = ERROR_OK;
@@ -909,11 +996,20 @@ static const struct command_registration flash_exec_command_handlers[] = {
 		.name = "write_image",
 		.handler = handle_flash_write_image_command,
 		.mode = COMMAND_EXEC,
-		.usage = "[erase] [unlock] filename [offset [file_type]]",
+		.usage = "[erase] [unlock] [diff] filename [offset [file_type]]",
 		.help = "Write an image to flash.  Optionally first unprotect "
-			"and/or erase the region to be used.  Allow optional "
+			"and/or erase the region to be used, or skip sectors "
+			"whose contents already match.  Allow optional "
 			"offset from beginning of bank (defaults to zero)",
 	},
+	{
+		.name = "write_image_gang",
+		.handler = handle_flash_write_image_gang_command,
+		.mode = COMMAND_EXEC,
+		.usage = "[erase] [unlock] target_list filename [offset [file_type]]",
+		.help = "Write one image to the flash of each listed target, "
+			"parsing the image only once, and report per target.",
+	},
 	{
 		.name = "read_bank",
 		.handler = handle_flash_read_bank_command,
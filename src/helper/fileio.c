@@ -167,6 +167,22 @@ int fileio_seek(struct fileio *fileio, size_t position)
 	return ERROR_OK;
 }
 
+int fileio_tell(struct fileio *fileio, size_t *position)
+{
+	long retval;
+
+	retval = ftell(fileio->file);
+
+	if (retval < 0) {
+		LOG_ERROR("couldn't get position in file %s: %s", fileio->url, strerror(errno));
+		return ERROR_FILEIO_OPERATION_FAILED;
+	}
+
+	*position = retval;
+
+	return ERROR_OK;
+}
+
 static int fileio_local_read(struct fileio *fileio, size_t size, void *buffer,
 		size_t *size_read)
 {
@@ -48,6 +48,7 @@ int fileio_open(struct fileio **fileio, const char *url,
 int fileio_close(struct fileio *fileio);
 
 int fileio_seek(struct fileio *fileio, size_t position);
+int fileio_tell(struct fileio *fileio, size_t *position);
 int fileio_fgets(struct fileio *fileio, size_t size, void *buffer);
 
 int fileio_read(struct fileio *fileio,
@@ -456,6 +456,104 @@ COMMAND_HANDLER(handle_adapter_khz_command)
 	return retval;
 }
 
+COMMAND_HANDLER(handle_adapter_trace_enable_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	jtag_trace_enable(true);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_adapter_trace_disable_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	jtag_trace_enable(false);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_adapter_trace_clear_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	jtag_trace_clear();
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_adapter_trace_histogram_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	command_print(CMD_CTX, "adapter trace %s",
+			jtag_trace_is_enabled() ? "enabled" : "disabled");
+
+	for (int source = 0; source < JTAG_TRACE_NUM_SOURCES; source++) {
+		const uint32_t *hist = jtag_trace_histogram(source);
+
+		for (unsigned i = 0; i < JTAG_TRACE_BUCKETS; i++) {
+			if (hist[i] == 0)
+				continue;
+			/* source, lowest and highest us of the bucket, count */
+			command_print(CMD_CTX, "%s %u %u %" PRIu32,
+					jtag_trace_source_name(source),
+					i == 0 ? 0 : 1u << i, (2u << i) - 1, hist[i]);
+		}
+	}
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_adapter_trace_dump_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	return jtag_trace_dump(CMD_ARGV[0]);
+}
+
+static const struct command_registration adapter_trace_command_handlers[] = {
+	{
+		.name = "enable",
+		.handler = handle_adapter_trace_enable_command,
+		.mode = COMMAND_ANY,
+		.help = "start recording adapter queue flushes",
+		.usage = "",
+	},
+	{
+		.name = "disable",
+		.handler = handle_adapter_trace_disable_command,
+		.mode = COMMAND_ANY,
+		.help = "stop recording adapter queue flushes",
+		.usage = "",
+	},
+	{
+		.name = "clear",
+		.handler = handle_adapter_trace_clear_command,
+		.mode = COMMAND_ANY,
+		.help = "drop recorded flushes and histograms",
+		.usage = "",
+	},
+	{
+		.name = "histogram",
+		.handler = handle_adapter_trace_histogram_command,
+		.mode = COMMAND_ANY,
+		.help = "show the flush latency histogram of each trace source",
+		.usage = "",
+	},
+	{
+		.name = "dump",
+		.handler = handle_adapter_trace_dump_command,
+		.mode = COMMAND_ANY,
+		.help = "write the most recent flushes to a CSV file",
+		.usage = "filename",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
 static const struct command_registration interface_command_handlers[] = {
 	{
 		.name = "adapter_khz",
@@ -520,6 +618,13 @@ static const struct command_registration interface_command_handlers[] = {
 			"[srst_push_pull|srst_open_drain] "
 			"[connect_deassert_srst|connect_assert_srst]",
 	},
+	{
+		.name = "adapter_trace",
+		.mode = COMMAND_ANY,
+		.help = "adapter queue flush tracing",
+		.usage = "",
+		.chain = adapter_trace_command_handlers,
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
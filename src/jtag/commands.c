@@ -36,12 +36,21 @@
 struct cmd_queue_page {
 	struct cmd_queue_page *next;
 	void *address;
+	size_t size;
 	size_t used;
 };
 
+/*
+ * The pages form an arena that is recycled, not freed, when the queue is
+ * reset, so it only grows to the high-water mark of a single queue.
+ * cmd_queue_pages_tail is the page allocations currently come from, any
+ * pages after it are empty and waiting to be reused.
+ */
 #define CMD_QUEUE_PAGE_SIZE (1024 * 1024)
 static struct cmd_queue_page *cmd_queue_pages;
 static struct cmd_queue_page *cmd_queue_pages_tail;
+static size_t cmd_queue_used;
+static struct cmd_queue_stats cmd_queue_stats;
 
 struct jtag_command *jtag_command_queue;
 static struct jtag_command **next_command_pointer = &jtag_command_queue;
@@ -62,8 +71,8 @@ void jtag_queue_command(struct jtag_command *cmd)
 
 void *cmd_queue_alloc(size_t size)
 {
-	struct cmd_queue_page **p_page = &cmd_queue_pages;
-	int offset;
+	struct cmd_queue_page *page;
+	size_t offset;
 	uint8_t *t;
 
 	/*
@@ -98,47 +107,83 @@ void *cmd_queue_alloc(size_t size)
 	size = (size + ALIGN_SIZE - 1) & (~(ALIGN_SIZE - 1));
 	/* Done... */
 
-	if (*p_page) {
-		p_page = &cmd_queue_pages_tail;
-		if (CMD_QUEUE_PAGE_SIZE - (*p_page)->used < size)
-			p_page = &((*p_page)->next);
+	page = cmd_queue_pages_tail;
+	if (page && page->size - page->used < size) {
+		/* move on to the next recycled page, if it is big enough */
+		page = page->next;
+		if (page && page->size < size)
+			page = NULL;
 	}
 
-	if (!*p_page) {
-		*p_page = malloc(sizeof(struct cmd_queue_page));
-		(*p_page)->used = 0;
-		size_t alloc_size = (size < CMD_QUEUE_PAGE_SIZE) ?
+	if (!page) {
+		page = malloc(sizeof(struct cmd_queue_page));
+		page->used = 0;
+		page->size = (size < CMD_QUEUE_PAGE_SIZE) ?
 					CMD_QUEUE_PAGE_SIZE : size;
-		(*p_page)->address = malloc(alloc_size);
-		(*p_page)->next = NULL;
-		cmd_queue_pages_tail = *p_page;
+		page->address = malloc(page->size);
+
+		/* insert it right after the current page, ahead of any recycled ones */
+		if (cmd_queue_pages_tail) {
+			page->next = cmd_queue_pages_tail->next;
+			cmd_queue_pages_tail->next = page;
+		} else {
+			page->next = NULL;
+			cmd_queue_pages = page;
+		}
+
+		cmd_queue_stats.pages++;
+		cmd_queue_stats.bytes += page->size;
+		cmd_queue_stats.page_allocs++;
 	}
+	cmd_queue_pages_tail = page;
 
-	offset = (*p_page)->used;
-	(*p_page)->used += size;
+	offset = page->used;
+	page->used += size;
+	cmd_queue_used += size;
 
-	t = (*p_page)->address;
+	t = page->address;
 	return t + offset;
 }
 
-static void cmd_queue_free(void)
+static void cmd_queue_recycle(void)
 {
-	struct cmd_queue_page *page = cmd_queue_pages;
+	struct cmd_queue_page **p_page = &cmd_queue_pages;
 
-	while (page) {
-		struct cmd_queue_page *last = page;
-		free(page->address);
-		page = page->next;
-		free(last);
+	while (*p_page) {
+		struct cmd_queue_page *page = *p_page;
+
+		/* oversized pages were made for one huge request, don't keep them */
+		if (page->size > CMD_QUEUE_PAGE_SIZE) {
+			*p_page = page->next;
+			cmd_queue_stats.pages--;
+			cmd_queue_stats.bytes -= page->size;
+			free(page->address);
+			free(page);
+			continue;
+		}
+
+		page->used = 0;
+		p_page = &page->next;
 	}
 
-	cmd_queue_pages = NULL;
-	cmd_queue_pages_tail = NULL;
+	cmd_queue_pages_tail = cmd_queue_pages;
+
+	if (cmd_queue_used > cmd_queue_stats.peak_bytes)
+		cmd_queue_stats.peak_bytes = cmd_queue_used;
+	cmd_queue_used = 0;
+	cmd_queue_stats.resets++;
+}
+
+void cmd_queue_get_stats(struct cmd_queue_stats *stats)
+{
+	*stats = cmd_queue_stats;
+	if (cmd_queue_used > stats->peak_bytes)
+		stats->peak_bytes = cmd_queue_used;
 }
 
 void jtag_command_queue_reset(void)
 {
-	cmd_queue_free();
+	cmd_queue_recycle();
 
 	jtag_command_queue = NULL;
 	next_command_pointer = &jtag_command_queue;
@@ -165,6 +165,22 @@ extern struct jtag_command *jtag_command_queue;
 
 void *cmd_queue_alloc(size_t size);
 
+/** Allocation counters of the memory backing the command queue. */
+struct cmd_queue_stats {
+	/** pages currently held by the arena */
+	unsigned pages;
+	/** bytes currently held by the arena */
+	size_t bytes;
+	/** most bytes handed out between two queue resets */
+	size_t peak_bytes;
+	/** pages malloc()ed since startup */
+	unsigned page_allocs;
+	/** queue resets since startup */
+	unsigned resets;
+};
+
+void cmd_queue_get_stats(struct cmd_queue_stats *stats);
+
 void jtag_queue_command(struct jtag_command *cmd);
 void jtag_command_queue_reset(void);
 
@@ -46,6 +46,28 @@
 
 /** The number of JTAG queue flushes (for profiling and debugging purposes). */
 static int jtag_flush_queue_count;
+static unsigned jtag_usb_transfer_count;
+static uint64_t jtag_usb_byte_count;
+
+/* The adapter trace, a ring of the most recent flushes and a latency
+ * histogram per source, kept while enabled. */
+#define JTAG_TRACE_RING_SIZE 4096
+
+struct jtag_trace_record {
+	int64_t start_us;
+	uint32_t duration_us;
+	enum jtag_trace_source source;
+	unsigned commands;
+	unsigned bits;
+	unsigned usb_transfers;
+	unsigned usb_bytes;
+};
+
+static bool jtag_trace_enabled;
+static struct jtag_trace_record *jtag_trace_ring;
+static unsigned jtag_trace_next;
+static unsigned jtag_trace_count;
+static uint32_t jtag_trace_hist[JTAG_TRACE_NUM_SOURCES][JTAG_TRACE_BUCKETS];
 
 /* Sleep this # of ms after flushing the queue */
 static int jtag_flush_queue_sleep;
@@ -841,9 +863,16 @@ int default_interface_jtag_execute_queue(void)
 
 void jtag_execute_queue_noclear(void)
 {
+	struct jtag_trace_span span;
+
+	jtag_trace_begin(&span, JTAG_TRACE_QUEUE);
+	jtag_trace_count_queue(&span, jtag_command_queue);
+
 	jtag_flush_queue_count++;
 	jtag_set_error(interface_jtag_execute_queue());
 
+	jtag_trace_end(&span);
+
 	if (jtag_flush_queue_sleep > 0) {
 		/* For debug purposes it can be useful to test performance
 		 * or behavior when delaying after flushing the queue,
@@ -858,6 +887,171 @@ int jtag_get_flush_queue_count(void)
 	return jtag_flush_queue_count;
 }
 
+void jtag_count_queue_flush(void)
+{
+	jtag_flush_queue_count++;
+}
+
+void jtag_count_usb_transfers(unsigned count, unsigned bytes)
+{
+	jtag_usb_transfer_count += count;
+	jtag_usb_byte_count += bytes;
+}
+
+unsigned jtag_get_usb_transfer_count(void)
+{
+	return jtag_usb_transfer_count;
+}
+
+static int64_t jtag_trace_now_us(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+void jtag_trace_begin(struct jtag_trace_span *span, enum jtag_trace_source source)
+{
+	span->active = jtag_trace_enabled;
+	if (!span->active)
+		return;
+
+	span->source = source;
+	span->commands = 0;
+	span->bits = 0;
+	span->usb_transfers = jtag_usb_transfer_count;
+	span->usb_bytes = jtag_usb_byte_count;
+	span->start_us = jtag_trace_now_us();
+}
+
+void jtag_trace_count_queue(struct jtag_trace_span *span, const struct jtag_command *cmd)
+{
+	if (!span->active)
+		return;
+
+	for (; cmd; cmd = cmd->next) {
+		span->commands++;
+		switch (cmd->type) {
+			case JTAG_SCAN:
+				for (int i = 0; i < cmd->cmd.scan->num_fields; i++)
+					span->bits += cmd->cmd.scan->fields[i].num_bits;
+				break;
+			case JTAG_RUNTEST:
+				span->bits += cmd->cmd.runtest->num_cycles;
+				break;
+			case JTAG_STABLECLOCKS:
+				span->bits += cmd->cmd.stableclocks->num_cycles;
+				break;
+			case JTAG_PATHMOVE:
+				span->bits += cmd->cmd.pathmove->num_states;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+void jtag_trace_end(struct jtag_trace_span *span)
+{
+	/* also skips spans started before the trace was enabled */
+	if (!span->active || !jtag_trace_enabled)
+		return;
+
+	int64_t duration = jtag_trace_now_us() - span->start_us;
+	if (duration < 0)
+		duration = 0;
+
+	if (jtag_trace_ring != NULL) {
+		struct jtag_trace_record *record = &jtag_trace_ring[jtag_trace_next];
+
+		record->start_us = span->start_us;
+		record->duration_us = MIN(duration, UINT32_MAX);
+		record->source = span->source;
+		record->commands = span->commands;
+		record->bits = span->bits;
+		record->usb_transfers = jtag_usb_transfer_count - span->usb_transfers;
+		record->usb_bytes = jtag_usb_byte_count - span->usb_bytes;
+
+		jtag_trace_next = (jtag_trace_next + 1) % JTAG_TRACE_RING_SIZE;
+		if (jtag_trace_count < JTAG_TRACE_RING_SIZE)
+			jtag_trace_count++;
+	}
+
+	unsigned bucket = 0;
+	while (bucket < JTAG_TRACE_BUCKETS - 1 && duration >= (2 << bucket))
+		bucket++;
+	jtag_trace_hist[span->source][bucket]++;
+}
+
+void jtag_trace_enable(bool enable)
+{
+	if (enable && jtag_trace_ring == NULL) {
+		jtag_trace_ring = calloc(JTAG_TRACE_RING_SIZE, sizeof(*jtag_trace_ring));
+		if (jtag_trace_ring == NULL)
+			LOG_WARNING("no memory for the adapter trace, only keeping histograms");
+	}
+	jtag_trace_enabled = enable;
+}
+
+bool jtag_trace_is_enabled(void)
+{
+	return jtag_trace_enabled;
+}
+
+void jtag_trace_clear(void)
+{
+	jtag_trace_next = 0;
+	jtag_trace_count = 0;
+	memset(jtag_trace_hist, 0, sizeof(jtag_trace_hist));
+}
+
+const char *jtag_trace_source_name(enum jtag_trace_source source)
+{
+	static const char * const names[JTAG_TRACE_NUM_SOURCES] = {
+		[JTAG_TRACE_QUEUE] = "queue",
+		[JTAG_TRACE_BITQ] = "bitq",
+		[JTAG_TRACE_MPSSE] = "mpsse",
+		[JTAG_TRACE_SWD] = "swd",
+	};
+
+	return names[source];
+}
+
+const uint32_t *jtag_trace_histogram(enum jtag_trace_source source)
+{
+	return jtag_trace_hist[source];
+}
+
+int jtag_trace_dump(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		LOG_ERROR("couldn't open %s: %s", filename, strerror(errno));
+		return ERROR_FAIL;
+	}
+
+	fprintf(f, "start_us,source,duration_us,commands,bits,usb_transfers,usb_bytes\n");
+
+	unsigned first = (jtag_trace_next + JTAG_TRACE_RING_SIZE - jtag_trace_count)
+		% JTAG_TRACE_RING_SIZE;
+	for (unsigned i = 0; i < jtag_trace_count; i++) {
+		const struct jtag_trace_record *r =
+			&jtag_trace_ring[(first + i) % JTAG_TRACE_RING_SIZE];
+
+		fprintf(f, "%" PRId64 ",%s,%" PRIu32 ",%u,%u,%u,%u\n",
+				r->start_us, jtag_trace_source_name(r->source), r->duration_us,
+				r->commands, r->bits, r->usb_transfers, r->usb_bytes);
+	}
+
+	if (fclose(f) != 0) {
+		LOG_ERROR("couldn't write %s", filename);
+		return ERROR_FAIL;
+	}
+
+	return ERROR_OK;
+}
+
 int jtag_execute_queue(void)
 {
 	jtag_execute_queue_noclear();
@@ -35,6 +35,60 @@ struct bitq_state {
 };
 static struct bitq_state bitq_in_state;
 
+/* copy num_bits packed bits, shifting whole 32 bit words where possible */
+static void bitq_copy_bits(uint8_t *dst, unsigned dst_offset,
+		const uint8_t *src, unsigned src_offset, unsigned num_bits)
+{
+	dst += dst_offset / 8;
+	dst_offset %= 8;
+	src += src_offset / 8;
+	src_offset %= 8;
+
+	/* single bits until the destination is byte aligned */
+	while (num_bits > 0 && dst_offset != 0) {
+		if (*src & (1 << src_offset))
+			*dst |= 1 << dst_offset;
+		else
+			*dst &= ~(1 << dst_offset);
+		if (++src_offset == 8) {
+			src_offset = 0;
+			src++;
+		}
+		if (++dst_offset == 8) {
+			dst_offset = 0;
+			dst++;
+		}
+		num_bits--;
+	}
+
+	if (src_offset == 0) {
+		memcpy(dst, src, num_bits / 8);
+		dst += num_bits / 8;
+		src += num_bits / 8;
+	} else {
+		/* a word spans five source bytes, all of them holding requested bits */
+		for (; num_bits >= 32; num_bits -= 32, src += 4, dst += 4) {
+			uint64_t word = le_to_h_u32(src) | ((uint64_t)src[4] << 32);
+			h_u32_to_le(dst, (uint32_t)(word >> src_offset));
+		}
+		for (; num_bits >= 8; num_bits -= 8, src++, dst++)
+			*dst = (src[0] >> src_offset) | (src[1] << (8 - src_offset));
+	}
+	num_bits %= 8;
+
+	/* remaining bits, dst_offset is 0 here */
+	for (; num_bits > 0; num_bits--, dst_offset++) {
+		if (*src & (1 << src_offset))
+			*dst |= 1 << dst_offset;
+		else
+			*dst &= ~(1 << dst_offset);
+		if (++src_offset == 8) {
+			src_offset = 0;
+			src++;
+		}
+	}
+}
+
 /*
  * input queue processing does not use jtag_read_buffer() to avoid unnecessary overhead
  * no parameters, makes use of stored state information
@@ -49,7 +103,24 @@ static void bitq_in_proc(void)
 			while (bitq_in_state.field_idx < bitq_in_state.cmd->cmd.scan->num_fields) {
 				struct scan_field *field;
 				field = &bitq_in_state.cmd->cmd.scan->fields[bitq_in_state.field_idx];
-				if (field->in_value) {
+				if (field->in_value && bitq_interface->in_bulk) {
+					/* bulk copy of whatever the interface has ready */
+					while (bitq_in_state.bit_pos < field->num_bits) {
+						const uint8_t *bits;
+						unsigned offset;
+						int count = bitq_interface->in_bulk(&bits, &offset,
+								field->num_bits - bitq_in_state.bit_pos);
+						if (count <= 0) {
+#ifdef _DEBUG_JTAG_IO_
+							LOG_DEBUG("bitq in EOF");
+#endif
+							return;
+						}
+						bitq_copy_bits(field->in_value, bitq_in_state.bit_pos,
+								bits, offset, count);
+						bitq_in_state.bit_pos += count;
+					}
+				} else if (field->in_value) {
 					/* field scanning */
 					while (bitq_in_state.bit_pos < field->num_bits) {
 						/* index of byte being scanned */
@@ -89,6 +160,40 @@ static void bitq_io(int tms, int tdi, int tdo_req)
 		bitq_in_proc();
 }
 
+static void bitq_io_bits(const uint8_t *tdi, int num_bits, int tdo_req)
+{
+	int bit_pos = 0;
+
+	while (bit_pos < num_bits) {
+		int count = bitq_interface->out_bits(0, tdi, bit_pos, num_bits - bit_pos, tdo_req);
+		if (count <= 0)
+			break;
+		bit_pos += count;
+		/* check and process the input queue */
+		if (bitq_interface->in_rdy())
+			bitq_in_proc();
+	}
+}
+
+static void bitq_io_repeat(int tms, int tdi, int count)
+{
+	if (!bitq_interface->out_repeat) {
+		while (count-- > 0)
+			bitq_io(tms, tdi, 0);
+		return;
+	}
+
+	while (count > 0) {
+		int queued = bitq_interface->out_repeat(tms, tdi, count);
+		if (queued <= 0)
+			break;
+		count -= queued;
+		/* check and process the input queue */
+		if (bitq_interface->in_rdy())
+			bitq_in_proc();
+	}
+}
+
 static void bitq_end_state(tap_state_t state)
 {
 	if (!tap_is_state_stable(state)) {
@@ -100,7 +205,7 @@ static void bitq_end_state(tap_state_t state)
 
 static void bitq_state_move(tap_state_t new_state)
 {
-	int i = 0;
+	int i, run;
 	uint8_t  tms_scan;
 
 	if (!tap_is_state_stable(tap_get_state()) || !tap_is_state_stable(new_state)) {
@@ -111,9 +216,14 @@ static void bitq_state_move(tap_state_t new_state)
 	tms_scan = tap_get_tms_path(tap_get_state(), new_state);
 	int tms_count = tap_get_tms_path_len(tap_get_state(), new_state);
 
-	for (i = 0; i < tms_count; i++) {
-		bitq_io(tms_scan & 1, 0, 0);
-		tms_scan >>= 1;
+	/* clock out runs of equal TMS bits at once */
+	for (i = 0; i < tms_count; i += run) {
+		int tms = (tms_scan >> i) & 1;
+		for (run = 1; i + run < tms_count; run++) {
+			if (((tms_scan >> (i + run)) & 1) != tms)
+				break;
+		}
+		bitq_io_repeat(tms, 0, run);
 	}
 
 	tap_set_state(new_state);
@@ -142,21 +252,26 @@ static void bitq_path_move(struct pathmove_command *cmd)
 
 static void bitq_runtest(int num_cycles)
 {
-	int i;
-
 	/* only do a state_move when we're not already in IDLE */
 	if (tap_get_state() != TAP_IDLE)
 		bitq_state_move(TAP_IDLE);
 
 	/* execute num_cycles */
-	for (i = 0; i < num_cycles; i++)
-		bitq_io(0, 0, 0);
+	bitq_io_repeat(0, 0, num_cycles);
 
 	/* finish in end_state */
 	if (tap_get_state() != tap_get_end_state())
 		bitq_state_move(tap_get_end_state());
 }
 
+static void bitq_stableclocks(int num_cycles)
+{
+	/* stay in the current stable state, only TLR needs TMS high */
+	int tms = (tap_get_state() == TAP_RESET ? 1 : 0);
+
+	bitq_io_repeat(tms, 0, num_cycles);
+}
+
 static void bitq_scan_field(struct scan_field *field, int do_pause)
 {
 	int bit_cnt;
@@ -170,7 +285,14 @@ static void bitq_scan_field(struct scan_field *field, int do_pause)
 	else
 		tdo_req = 0;
 
-	if (field->out_value == NULL) {
+	if (bitq_interface->out_bits) {
+		/* all but the last bit share TMS=0, let the interface pack them */
+		bitq_io_bits(field->out_value, field->num_bits - 1, tdo_req);
+
+		int last = field->num_bits - 1;
+		bitq_io(do_pause, field->out_value &&
+				(field->out_value[last / 8] & (1 << (last % 8))), tdo_req);
+	} else if (field->out_value == NULL) {
 		/* just send zeros and request data from TDO */
 		for (bit_cnt = field->num_bits; bit_cnt > 1; bit_cnt--)
 			bitq_io(0, 0, tdo_req);
@@ -216,7 +338,7 @@ static void bitq_scan(struct scan_command *cmd)
 	bitq_scan_field(&cmd->fields[i], 1);
 }
 
-int bitq_execute_queue(void)
+static int bitq_run_queue(void)
 {
 	struct jtag_command *cmd = jtag_command_queue; /* currently processed command */
 
@@ -248,6 +370,13 @@ int bitq_execute_queue(void)
 			bitq_runtest(cmd->cmd.runtest->num_cycles);
 			break;
 
+		case JTAG_STABLECLOCKS:
+			/* this is only allowed while in a stable state.  A check for a stable
+			 * state was done in jtag_add_clocks()
+			 */
+			bitq_stableclocks(cmd->cmd.stableclocks->num_cycles);
+			break;
+
 		case JTAG_TLR_RESET:
 #ifdef _DEBUG_JTAG_IO_
 			LOG_DEBUG("statemove end in %i", cmd->cmd.statemove->end_state);
@@ -310,6 +439,19 @@ int bitq_execute_queue(void)
 	return bitq_in_state.status;
 }
 
+int bitq_execute_queue(void)
+{
+	struct jtag_trace_span span;
+	int retval;
+
+	jtag_trace_begin(&span, JTAG_TRACE_BITQ);
+	jtag_trace_count_queue(&span, jtag_command_queue);
+	retval = bitq_run_queue();
+	jtag_trace_end(&span);
+
+	return retval;
+}
+
 void bitq_cleanup(void)
 {
 }
@@ -26,6 +26,18 @@ struct bitq_interface {
 	int (*out)(int tms, int tdi, int tdo_req);
 	int (*flush)(void);
 
+	/* optional bulk version of out(): enqueue up to num_bits clocks with
+	 * constant TMS and TDI taken from bit tdi_offset onwards of the packed
+	 * tdi vector (all zeros if tdi is NULL), returns number of clocks queued
+	 */
+	int (*out_bits)(int tms, const uint8_t *tdi, unsigned tdi_offset,
+			unsigned num_bits, int tdo_req);
+
+	/* optional: enqueue up to count clocks with constant TMS and TDI and
+	 * no TDO request, returns number of clocks queued
+	 */
+	int (*out_repeat)(int tms, int tdi, int count);
+
 	int (*sleep)(unsigned long us);
 	int (*reset)(int trst, int srst);
 
@@ -34,6 +46,13 @@ struct bitq_interface {
 	 */
 	int (*in_rdy)(void);
 	int (*in)(void);
+
+	/* optional bulk read of requested TDO data: returns the number of
+	 * available bits (at most max_bits) and points *bits and *offset at them,
+	 * packed LSB first; the returned bits are consumed and stay valid
+	 * until the next call to any other bitq_interface function
+	 */
+	int (*in_bulk)(const uint8_t **bits, unsigned *offset, unsigned max_bits);
 };
 
 extern struct bitq_interface *bitq_interface;
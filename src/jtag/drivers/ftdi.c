@@ -1077,6 +1077,10 @@ static int ftdi_swd_run_queue(void)
 	LOG_DEBUG("Executing %zu queued transactions", swd_cmd_queue_length);
 	int retval;
 	struct signal *led = find_signal_by_name("LED");
+	struct jtag_trace_span span;
+
+	jtag_trace_begin(&span, JTAG_TRACE_SWD);
+	span.commands = swd_cmd_queue_length;
 
 	if (queued_retval != ERROR_OK) {
 		LOG_DEBUG("Skipping due to previous errors: %d", queued_retval);
@@ -1136,6 +1140,7 @@ skip:
 	if (led && retval == ERROR_OK)
 		ftdi_set_signal(led, '1');
 
+	jtag_trace_end(&span);
 	return retval;
 }
 
@@ -26,12 +26,17 @@
 #include <jtag/interface.h>
 #include <jtag/commands.h>
 #include <jtag/drivers/bitq.h>
+#include <jtag/swd.h>
+#include <helper/time_support.h>
 #include <ftdi.h>
 
-struct ftdi_context *ftdi;
 static const int ftdi_friend_vid = 0x0403;
 static const int ftdi_friend_pid = 0x6001;
 
+/* Pick one of several boards on the same host. */
+static char *ftdi_friend_serial;
+static char *ftdi_friend_location;
+
 enum ft232r_pins {
     PIN_TXD = 0x01,
     PIN_RXD = 0x02,
@@ -73,30 +78,102 @@ static const uint8_t ftdi_output_mask =
 
 static uint8_t latency_timer = 1;
 
-enum { buffer_size = 1 << 14, frame_size = 1 << 8 };
+/*
+ * The FT232R has a 128 byte receive and a 256 byte transmit FIFO and moves
+ * data in 64 byte USB packets. Automatically sized frames are never smaller
+ * than what the chip buffers on its own.
+ */
+enum { ft232r_fifo_size = 256, usb_packet_size = 64 };
+
+/*
+ * Bytes of pin data queued before a flush is forced, and the size of the
+ * individual USB transfers a flush is split into.
+ */
+static int buffer_size = 1 << 14;
+static int frame_size = 1 << 8;
+static bool auto_frame_size;
+static unsigned latency_us;
+
+/*
+ * Most of the stream is TMS moves, idle clocks and write-only scans, so the
+ * tx buffer keeps a flag per USB packet worth of data telling whether any
+ * byte in it requests a TDO sample. The rx side skips unflagged packets.
+ */
+enum { sample_chunk_size = usb_packet_size };
 
 struct buffer {
-    uint8_t data[buffer_size];
-    uint16_t available;
+    uint8_t *data;
+    uint8_t *sampled;
+    int available;
+};
+
+/* Sampled TDO bits, packed LSB first like scan_field::in_value. */
+struct bit_vector {
+    uint8_t *data;
+    int available;
+};
+
+/* Everything tied to the one adapter this openocd instance talks to. */
+struct ftdi_friend {
+    struct ftdi_context *ftdi;
+    struct buffer tx_buffer;
+    struct bit_vector rx_buffer;
+    uint8_t *rd_buffer;
+    int rx_idx;
+};
+
+static struct ftdi_friend *ctx;
+
+/*
+ * SWD support. SWCLK is TCK and SWDIO is TDI tied to TDO through a resistor,
+ * so the target can always override what we drive and we read it back on
+ * TDO. Transactions are queued straight into the tx buffer, with TDO
+ * sampled only for the ACK, data and parity bits, and decoded from the
+ * packed rx bits when the queue runs.
+ */
+struct swd_cmd_queue_entry {
+    uint8_t cmd;
+    uint32_t *dst;
+    int rx_offset;
 };
 
-static struct buffer tx_buffer;
-static struct buffer rx_buffer;
-uint16_t rx_idx = 0;
+static struct swd_cmd_queue_entry *swd_cmd_queue;
+static size_t swd_cmd_queue_length;
+static size_t swd_cmd_queue_alloced;
+static int swd_samples_queued;
+/* bits clocked out since the last run, for the adapter trace */
+static unsigned swd_bits_queued;
+static int queued_retval;
 
 static int on_ftdi_error(const char *when)
 {
-    LOG_ERROR("libftdi call failed: %s: %s", when, ftdi_get_error_string(ftdi));
-    ftdi_free(ftdi);
-    ftdi = NULL;
+    LOG_ERROR("libftdi call failed: %s: %s", when, ftdi_get_error_string(ctx->ftdi));
+    ftdi_free(ctx->ftdi);
+    ctx->ftdi = NULL;
     return ERROR_FAIL;
 }
 
+static void mark_sampled(int start, int end)
+{
+    for (int chunk = start / sample_chunk_size;
+         chunk <= (end - 1) / sample_chunk_size; ++chunk) {
+        ctx->tx_buffer.sampled[chunk] = 1;
+    }
+}
+
+static void clear_sampled(int end)
+{
+    if (!ctx->tx_buffer.sampled) return;
+    memset(ctx->tx_buffer.sampled, 0, DIV_ROUND_UP(end, sample_chunk_size));
+}
+
 static void on_ftdi_warning(const char *when)
 {
-    LOG_WARNING("libftdi call failed: %s: %s", when, ftdi_get_error_string(ftdi));
-    tx_buffer.available = 0;
-    rx_buffer.available = 0;
+    LOG_WARNING("libftdi call failed: %s: %s", when, ftdi_get_error_string(ctx->ftdi));
+    clear_sampled(buffer_size);
+    ctx->tx_buffer.available = 0;
+    ctx->rx_buffer.available = 0;
+    ctx->rx_idx = 0;
 }
 
 static int buffer_empty(struct buffer *buf)
@@ -106,66 +183,118 @@ static int buffer_empty(struct buffer *buf)
 
 static int buffer_full(struct buffer *buf)
 {
-    return buf->available == sizeof(buf->data);
+    return buf->available == buffer_size;
+}
+
+/*
+ * Writes in flight while a flush is running. Only one read can be pending
+ * at a time since libftdi reads every submitted transfer into the context's
+ * single read buffer, but writes use our tx buffer directly, so keeping
+ * several of them queued ahead means the chip never waits on the host.
+ */
+enum { max_queue_depth = 64 };
+static unsigned queue_depth = 4;
+
+struct write_frame {
+    struct ftdi_transfer_control *tc;
+    int end;
+};
+
+static void unpack_tdo(int start, const uint8_t *received, int count)
+{
+    const uint8_t *sent = ctx->tx_buffer.data + start;
+
+    for (int i = 0; i < count; ++i) {
+        if ((start + i) % sample_chunk_size == 0 &&
+            !ctx->tx_buffer.sampled[(start + i) / sample_chunk_size]) {
+            i += MIN(sample_chunk_size, count - i) - 1;
+            continue;
+        }
+
+        if (sent[i] & PIN_TDO) {
+            uint8_t *rd_idx = &ctx->rx_buffer.data[ctx->rx_buffer.available / 8];
+            uint8_t mask = 1 << (ctx->rx_buffer.available % 8);
+            if (mask == 0x01) *rd_idx = 0;
+            if (received[i] & PIN_TDO) *rd_idx |= mask;
+            ctx->rx_buffer.available++;
+        }
+    }
 }
 
 static int flush_buffers(void)
 {
-    if (buffer_empty(&tx_buffer)) return ERROR_OK;
+    if (buffer_empty(&ctx->tx_buffer)) return ERROR_OK;
 
-    int num_to_write = tx_buffer.available;
-    int num_to_read = tx_buffer.available;
-    uint8_t *wr_idx = tx_buffer.data;
-    uint8_t *rwr_idx = tx_buffer.data;
-    uint8_t *rd_idx = rx_buffer.data;
+    int total = ctx->tx_buffer.available;
+    int num_submitted = 0;
+    int num_read = 0;
+    int retval = ERROR_OK;
 
-    uint8_t rd_buffer[frame_size];
-    rx_idx = 0;
-    tx_buffer.available = 0;
+    struct write_frame writes[max_queue_depth];
+    unsigned first_write = 0;
+    unsigned num_writes = 0;
 
-    while (1) {
-        struct ftdi_transfer_control *wtc = NULL;
-        struct ftdi_transfer_control *rtc = NULL;
+    ctx->rx_idx = 0;
+    ctx->rx_buffer.available = 0;
+    ctx->tx_buffer.available = 0;
 
-        if (num_to_write > 0) {
-            wtc = ftdi_write_data_submit(ftdi, wr_idx, MIN(frame_size, num_to_write));
-        }
+    while (num_read < total) {
+        while (num_writes < queue_depth && num_submitted < total) {
+            int len = MIN(frame_size, total - num_submitted);
+            struct write_frame *frame =
+                &writes[(first_write + num_writes) % max_queue_depth];
+
+            frame->tc = ftdi_write_data_submit(
+                ctx->ftdi, ctx->tx_buffer.data + num_submitted, len);
+            if (!frame->tc) break;
+            jtag_count_usb_transfers(1, len);
 
-        if (num_to_read > 0) {
-            rtc = ftdi_read_data_submit(ftdi, rd_buffer, MIN(frame_size, num_to_read));
+            num_submitted += len;
+            frame->end = num_submitted;
+            num_writes++;
         }
 
-        if (!wtc && !rtc) return ERROR_OK;
+        if (num_submitted == num_read) {
+            on_ftdi_warning("write");
+            retval = ERROR_FAIL;
+            break;
+        }
 
-        if (wtc) {
-            int rc = ftdi_transfer_data_done(wtc);
-            if (rc < 0) {
-                on_ftdi_warning("write");
-                return ERROR_FAIL;
-            }
-            num_to_write -= rc;
-            wr_idx += rc;
+        struct ftdi_transfer_control *rtc = ftdi_read_data_submit(
+            ctx->ftdi, ctx->rd_buffer, MIN(frame_size, num_submitted - num_read));
+        int rc = rtc ? ftdi_transfer_data_done(rtc) : -1;
+        jtag_count_usb_transfers(1, rc > 0 ? rc : 0);
+        if (rc < 0) {
+            on_ftdi_warning("read");
+            retval = ERROR_FAIL;
+            break;
         }
 
-        if (rtc) {
-            int rc = ftdi_transfer_data_done(rtc);
-            if (rc < 0) {
-                on_ftdi_warning("read");
-                return ERROR_FAIL;
-            }
+        unpack_tdo(num_read, ctx->rd_buffer, rc);
+        num_read += rc;
 
-            for (int i = 0; i < rc; ++i, ++rwr_idx)
-            {
-                if (*rwr_idx & PIN_TDO) {
-                    *rd_idx = !!(rd_buffer[i] & PIN_TDO);
-                    ++rd_idx;
-                    rx_buffer.available++;
-                }
+        /* Every write whose data has been echoed back is complete. */
+        while (num_writes > 0 && writes[first_write].end <= num_read) {
+            if (ftdi_transfer_data_done(writes[first_write].tc) < 0) {
+                on_ftdi_warning("write");
+                retval = ERROR_FAIL;
             }
-            num_to_read -= rc;
+            first_write = (first_write + 1) % max_queue_depth;
+            num_writes--;
         }
 
+        if (retval != ERROR_OK) break;
+    }
+
+    /* Don't leave transfers pointing into the tx buffer behind. */
+    for (; num_writes > 0; --num_writes) {
+        ftdi_transfer_data_done(writes[first_write].tc);
+        first_write = (first_write + 1) % max_queue_depth;
     }
+
+    clear_sampled(total);
+
+    return retval;
 }
 
 static void buffer_enqueue(struct buffer *buf, uint8_t data)
@@ -176,23 +305,120 @@ static void buffer_enqueue(struct buffer *buf, uint8_t data)
     buf->data[buf->available++] = data;
 }
 
-static int ftdi_friend_quit(void)
+static void free_buffers(void)
 {
-    if (!ftdi) return ERROR_OK;
+    free(ctx->tx_buffer.data);
+    free(ctx->tx_buffer.sampled);
+    free(ctx->rx_buffer.data);
+    free(ctx->rd_buffer);
+    ctx->tx_buffer.data = NULL;
+    ctx->tx_buffer.sampled = NULL;
+    ctx->rx_buffer.data = NULL;
+    ctx->rd_buffer = NULL;
+}
 
-    if (ftdi_usb_close(ftdi)) {
-        return on_ftdi_error("ftdi_usb_close");
+static int alloc_buffers(void)
+{
+    free_buffers();
+    ctx->tx_buffer.data = malloc(buffer_size);
+    ctx->tx_buffer.sampled = calloc(DIV_ROUND_UP(buffer_size, sample_chunk_size), 1);
+    ctx->rx_buffer.data = malloc(DIV_ROUND_UP(buffer_size, 8));
+    ctx->rd_buffer = malloc(buffer_size);
+    ctx->tx_buffer.available = 0;
+    ctx->rx_buffer.available = 0;
+    ctx->rx_idx = 0;
+
+    if (!ctx->tx_buffer.data || !ctx->tx_buffer.sampled || !ctx->rx_buffer.data || !ctx->rd_buffer) {
+        LOG_ERROR("failed to allocate %d byte buffers", buffer_size);
+        free_buffers();
+        return ERROR_FAIL;
     }
+    return ERROR_OK;
+}
+
+/*
+ * Time a few single byte sync-bitbang exchanges to estimate the USB round
+ * trip, which is dominated by the latency timer and the host controller.
+ */
+/* seconds to wait for the echo of a single byte before giving up */
+#define LATENCY_PROBE_TIMEOUT 1.0
+
+static int measure_latency(void)
+{
+    enum { rounds = 8 };
+    uint8_t idle_pins = PIN_TRST | PIN_SRST;
+    uint8_t sample;
+    struct duration bench;
 
-    ftdi_free(ftdi);
-    ftdi = NULL;
+    duration_start(&bench);
+    for (int i = 0; i < rounds; ++i) {
+        if (ftdi_write_data(ctx->ftdi, &idle_pins, 1) != 1) {
+            return on_ftdi_error("ftdi_write_data");
+        }
+
+        int rc;
+        struct duration wait;
+        duration_start(&wait);
+        while ((rc = ftdi_read_data(ctx->ftdi, &sample, 1)) == 0) {
+            duration_measure(&wait);
+            if (duration_elapsed(&wait) > LATENCY_PROBE_TIMEOUT) {
+                LOG_ERROR("no answer from the FTDI Friend while measuring latency");
+                return ERROR_FAIL;
+            }
+        }
+        if (rc < 0) {
+            return on_ftdi_error("ftdi_read_data");
+        }
+    }
+    duration_measure(&bench);
+
+    latency_us = duration_elapsed(&bench) * 1000000 / rounds;
     return ERROR_OK;
 }
 
+/*
+ * Split the data the chip consumes during one round trip (about one byte
+ * per baud clock in sync-bitbang mode) across the frames kept in flight.
+ */
+static void update_frame_size(int baudrate)
+{
+    if (!auto_frame_size) return;
+
+    uint64_t per_round_trip = (uint64_t)baudrate * latency_us / 1000000;
+    uint64_t size = DIV_ROUND_UP(per_round_trip / queue_depth, usb_packet_size) *
+        usb_packet_size;
+
+    frame_size = MIN(MAX(size, (uint64_t)ft232r_fifo_size), (uint64_t)buffer_size);
+    LOG_DEBUG("ftdi_friend: %u us round trip, using %d byte frames",
+              latency_us, frame_size);
+}
+
+static int ftdi_friend_quit(void)
+{
+    int retval = ERROR_OK;
+
+    free(swd_cmd_queue);
+    swd_cmd_queue = NULL;
+    if (!ctx) return ERROR_OK;
+
+    free_buffers();
+    if (ctx->ftdi) {
+        if (ftdi_usb_close(ctx->ftdi)) {
+            retval = on_ftdi_error("ftdi_usb_close");
+        } else {
+            ftdi_free(ctx->ftdi);
+        }
+    }
+
+    free(ctx);
+    ctx = NULL;
+    return retval;
+}
+
 static void write_data_pins(int tck, int tms, int tdi, int tdo_req)
 {
     buffer_enqueue(
-        &tx_buffer,
+        &ctx->tx_buffer,
         (tck ? PIN_TCK : 0) |
         (tms ? PIN_TMS : 0) |
         (tdi ? PIN_TDI : 0) |
@@ -200,12 +426,13 @@ static void write_data_pins(int tck, int tms, int tdi, int tdo_req)
         PIN_TRST |
         PIN_SRST
     );
+    if (tdo_req) mark_sampled(ctx->tx_buffer.available - 1, ctx->tx_buffer.available);
 }
 
 static int write_reset_pins(int trst, int srst)
 {
     buffer_enqueue(
-        &tx_buffer,
+        &ctx->tx_buffer,
         (trst ? 0 : PIN_TRST) |
         (srst ? 0 : PIN_SRST)
     );
@@ -218,6 +445,94 @@ static int clock_data(int tms, int tdi, int tdo_req) {
     return ERROR_OK;
 }
 
+/*
+ * Precomputed sync-bitbang streams for shifting one TDI byte (LSB first)
+ * with constant TMS, indexed by [tms][tdo_req][tdi byte]. Each bit takes
+ * the same two pin bytes clock_data() would produce.
+ */
+static uint8_t scan_templates[2][2][256][16];
+
+static void build_scan_templates(void)
+{
+    for (int tms = 0; tms < 2; ++tms) {
+        for (int tdo_req = 0; tdo_req < 2; ++tdo_req) {
+            for (int tdi = 0; tdi < 256; ++tdi) {
+                uint8_t *out = scan_templates[tms][tdo_req][tdi];
+                for (int bit = 0; bit < 8; ++bit) {
+                    uint8_t pins = (tms ? PIN_TMS : 0) |
+                        ((tdi >> bit) & 1 ? PIN_TDI : 0) |
+                        PIN_TRST |
+                        PIN_SRST;
+                    *out++ = pins;
+                    *out++ = pins | PIN_TCK | (tdo_req ? PIN_TDO : 0);
+                }
+            }
+        }
+    }
+}
+
+static int clock_data_bits(int tms, const uint8_t *tdi, unsigned tdi_offset,
+                           unsigned num_bits, int tdo_req)
+{
+    if (buffer_size - ctx->tx_buffer.available < 2) {
+        flush_buffers();
+    }
+
+    const uint8_t (*templates)[16] = scan_templates[!!tms][!!tdo_req];
+    unsigned room = (buffer_size - ctx->tx_buffer.available) / 2;
+    unsigned count = MIN(num_bits, room);
+    uint8_t *out = ctx->tx_buffer.data + ctx->tx_buffer.available;
+    unsigned pos = tdi_offset;
+    unsigned end = tdi_offset + count;
+
+    /* Single bits until TDI is byte aligned, then whole bytes. */
+    for (; pos < end && pos % 8; ++pos, out += 2) {
+        int bit = tdi ? (tdi[pos / 8] >> (pos % 8)) & 1 : 0;
+        memcpy(out, templates[bit], 2);
+    }
+
+    for (; pos + 8 <= end; pos += 8, out += 16) {
+        memcpy(out, templates[tdi ? tdi[pos / 8] : 0], 16);
+    }
+
+    for (; pos < end; ++pos, out += 2) {
+        int bit = tdi ? (tdi[pos / 8] >> (pos % 8)) & 1 : 0;
+        memcpy(out, templates[bit], 2);
+    }
+
+    if (tdo_req && count > 0) {
+        mark_sampled(ctx->tx_buffer.available, ctx->tx_buffer.available + 2 * count);
+    }
+    ctx->tx_buffer.available += 2 * count;
+    return count;
+}
+
+/*
+ * Clocks with constant pins: seed the stream from the scan templates, then
+ * keep doubling it with memcpy.
+ */
+static int clock_repeat(int tms, int tdi, int count)
+{
+    if (buffer_size - ctx->tx_buffer.available < 2) {
+        flush_buffers();
+    }
+
+    int room = (buffer_size - ctx->tx_buffer.available) / 2;
+    int len = 2 * MIN(count, room);
+    int filled = MIN(len, 16);
+    uint8_t *out = ctx->tx_buffer.data + ctx->tx_buffer.available;
+
+    memcpy(out, scan_templates[!!tms][0][tdi ? 0xff : 0x00], filled);
+    while (filled < len) {
+        int chunk = MIN(filled, len - filled);
+        memcpy(out + filled, out, chunk);
+        filled += chunk;
+    }
+
+    ctx->tx_buffer.available += len;
+    return len / 2;
+}
+
 __attribute__((unused))
 static void idle(void)
 {
@@ -226,9 +541,13 @@ static void idle(void)
 
 static int ftdi_friend_speed(int speed)
 {
-    if (ftdi_set_baudrate(ftdi, speed)) {
+    if (!ctx) return ERROR_OK;
+
+    flush_buffers();
+    if (ftdi_set_baudrate(ctx->ftdi, speed)) {
         on_ftdi_warning("ftdi_set_baudrate");
     }
+    update_frame_size(speed);
     return ERROR_OK;
 }
 
@@ -260,6 +579,91 @@ COMMAND_HANDLER(ftdi_friend_set_latency_timer)
     return ERROR_OK;
 }
 
+COMMAND_HANDLER(ftdi_friend_set_queue_depth)
+{
+    if (CMD_ARGC != 1) {
+        LOG_ERROR("ftdi_friend_queue_depth expects one argument "
+                  "in the range [1-%d]", max_queue_depth);
+        return ERROR_OK;
+    }
+
+    unsigned depth;
+    COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], depth);
+    if (depth < 1 || depth > max_queue_depth) {
+        LOG_ERROR("ftdi_friend_queue_depth must be in the range [1-%d]",
+                  max_queue_depth);
+        return ERROR_COMMAND_ARGUMENT_INVALID;
+    }
+
+    queue_depth = depth;
+    return ERROR_OK;
+}
+
+COMMAND_HANDLER(ftdi_friend_set_buffer_size)
+{
+    if (CMD_ARGC != 1) {
+        LOG_ERROR("ftdi_friend_buffer_size expects one argument");
+        return ERROR_OK;
+    }
+
+    int size;
+    COMMAND_PARSE_NUMBER(int, CMD_ARGV[0], size);
+    if (size < usb_packet_size || size % 2) {
+        LOG_ERROR("ftdi_friend_buffer_size must be an even number "
+                  "of at least %d bytes", usb_packet_size);
+        return ERROR_COMMAND_ARGUMENT_INVALID;
+    }
+
+    buffer_size = size;
+    frame_size = MIN(frame_size, buffer_size);
+    return ERROR_OK;
+}
+
+COMMAND_HANDLER(ftdi_friend_set_frame_size)
+{
+    if (CMD_ARGC != 1) {
+        LOG_ERROR("ftdi_friend_frame_size expects one argument");
+        return ERROR_OK;
+    }
+
+    if (strcmp(CMD_ARGV[0], "auto") == 0) {
+        auto_frame_size = true;
+        return ERROR_OK;
+    }
+
+    int size;
+    COMMAND_PARSE_NUMBER(int, CMD_ARGV[0], size);
+    if (size < 1 || size > buffer_size) {
+        LOG_ERROR("ftdi_friend_frame_size must be in the range [1-%d]",
+                  buffer_size);
+        return ERROR_COMMAND_ARGUMENT_INVALID;
+    }
+
+    auto_frame_size = false;
+    frame_size = size;
+    return ERROR_OK;
+}
+
+COMMAND_HANDLER(ftdi_friend_handle_serial_command)
+{
+    if (CMD_ARGC != 1) return ERROR_COMMAND_SYNTAX_ERROR;
+
+    free(ftdi_friend_serial);
+    ftdi_friend_serial = strdup(CMD_ARGV[0]);
+    return ERROR_OK;
+}
+
+#if defined(HAVE_LIBFTDI1) && defined(HAVE_LIBUSB_GET_PORT_NUMBERS)
+COMMAND_HANDLER(ftdi_friend_handle_location_command)
+{
+    if (CMD_ARGC != 1) return ERROR_COMMAND_SYNTAX_ERROR;
+
+    free(ftdi_friend_location);
+    ftdi_friend_location = strdup(CMD_ARGV[0]);
+    return ERROR_OK;
+}
+#endif
+
 static const struct command_registration ftdi_friend_command_handlers[] = {
     {
         .name = "ftdi_friend_latency_timer",
@@ -268,6 +672,44 @@ static const struct command_registration ftdi_friend_command_handlers[] = {
         .help = "Set the latency timer parameter in the FTDI API.",
         .usage = "ftdi_friend_latency_timer [time]"
     },
+    {
+        .name = "ftdi_friend_serial",
+        .handler = ftdi_friend_handle_serial_command,
+        .mode = COMMAND_CONFIG,
+        .help = "Set the serial number of the FTDI Friend to use.",
+        .usage = "serial_string"
+    },
+#if defined(HAVE_LIBFTDI1) && defined(HAVE_LIBUSB_GET_PORT_NUMBERS)
+    {
+        .name = "ftdi_friend_location",
+        .handler = ftdi_friend_handle_location_command,
+        .mode = COMMAND_CONFIG,
+        .help = "Set the USB bus location of the FTDI Friend to use.",
+        .usage = "<bus>:port[,port]..."
+    },
+#endif
+    {
+        .name = "ftdi_friend_queue_depth",
+        .handler = ftdi_friend_set_queue_depth,
+        .mode = COMMAND_CONFIG,
+        .help = "Set the number of USB write frames kept in flight.",
+        .usage = "ftdi_friend_queue_depth [frames]"
+    },
+    {
+        .name = "ftdi_friend_buffer_size",
+        .handler = ftdi_friend_set_buffer_size,
+        .mode = COMMAND_CONFIG,
+        .help = "Set the number of pin bytes queued before a flush is forced.",
+        .usage = "ftdi_friend_buffer_size [bytes]"
+    },
+    {
+        .name = "ftdi_friend_frame_size",
+        .handler = ftdi_friend_set_frame_size,
+        .mode = COMMAND_CONFIG,
+        .help = "Set the size of each USB transfer, or 'auto' to derive it "
+                "from the measured USB latency.",
+        .usage = "ftdi_friend_frame_size [bytes|auto]"
+    },
     COMMAND_REGISTRATION_DONE
 };
 
@@ -280,61 +722,438 @@ static int ftdi_friend_sleep(unsigned long us)
 
 static int ftdi_in_rdy(void)
 {
-    return rx_buffer.available;
+    return ctx->rx_buffer.available - ctx->rx_idx;
 }
 
 static int ftdi_in(void)
 {
     if (ftdi_in_rdy() > 0) {
-        rx_buffer.available--;
-        return rx_buffer.data[rx_idx++];
+        int tdo = (ctx->rx_buffer.data[ctx->rx_idx / 8] >> (ctx->rx_idx % 8)) & 1;
+        ctx->rx_idx++;
+        return tdo;
     }
     return -1;
 }
 
+static int ftdi_in_bulk(const uint8_t **bits, unsigned *offset, unsigned max_bits)
+{
+    unsigned count = MIN((unsigned)ftdi_in_rdy(), max_bits);
+
+    *bits = ctx->rx_buffer.data;
+    *offset = ctx->rx_idx;
+    ctx->rx_idx += count;
+    return count;
+}
+
 static struct bitq_interface ftdi_friend_bitq = {
     .out = clock_data,
+    .out_bits = clock_data_bits,
+    .out_repeat = clock_repeat,
     .flush = flush_buffers,
     .sleep = ftdi_friend_sleep,
     .reset = write_reset_pins,
     .in_rdy = ftdi_in_rdy,
     .in = ftdi_in,
+    .in_bulk = ftdi_in_bulk,
+};
+
+static void swd_clock_bits(const uint8_t *out, unsigned offset,
+                           unsigned num_bits, int tdo_req)
+{
+    if (tdo_req) swd_samples_queued += num_bits;
+    swd_bits_queued += num_bits;
+
+    while (num_bits > 0) {
+        int count = clock_data_bits(0, out, offset, num_bits, tdo_req);
+        offset += count;
+        num_bits -= count;
+    }
+}
+
+static int ftdi_friend_swd_init(void)
+{
+    LOG_INFO("FTDI Friend SWD mode enabled");
+
+    swd_cmd_queue_alloced = 10;
+    swd_cmd_queue = malloc(swd_cmd_queue_alloced * sizeof(*swd_cmd_queue));
+
+    return swd_cmd_queue != NULL ? ERROR_OK : ERROR_FAIL;
+}
+
+static int ftdi_friend_swd_run_queue(void)
+{
+    LOG_DEBUG("Executing %zu queued transactions", swd_cmd_queue_length);
+    int retval;
+    struct jtag_trace_span span;
+
+    jtag_trace_begin(&span, JTAG_TRACE_SWD);
+    span.commands = swd_cmd_queue_length;
+
+    if (queued_retval != ERROR_OK) {
+        LOG_DEBUG("Skipping due to previous errors: %d", queued_retval);
+        goto skip;
+    }
+
+    /*
+     * A transaction must be followed by another transaction or at least 8
+     * idle cycles to ensure that data is clocked through the AP.
+     */
+    swd_clock_bits(NULL, 0, 8, 0);
+    span.bits = swd_bits_queued;
+
+    queued_retval = flush_buffers();
+    if (queued_retval != ERROR_OK) {
+        LOG_ERROR("FTDI Friend SWD flush failed");
+        goto skip;
+    }
+
+    for (size_t i = 0; i < swd_cmd_queue_length; i++) {
+        struct swd_cmd_queue_entry *entry = &swd_cmd_queue[i];
+        int ack = buf_get_u32(ctx->rx_buffer.data, entry->rx_offset, 3);
+        bool is_read = entry->cmd & SWD_CMD_RnW;
+        uint32_t data = is_read ?
+            buf_get_u32(ctx->rx_buffer.data, entry->rx_offset + 3, 32) : 0;
+
+        LOG_DEBUG("%s %s %s reg %X = %08"PRIx32,
+                  ack == SWD_ACK_OK ? "OK" : ack == SWD_ACK_WAIT ? "WAIT" :
+                  ack == SWD_ACK_FAULT ? "FAULT" : "JUNK",
+                  entry->cmd & SWD_CMD_APnDP ? "AP" : "DP",
+                  is_read ? "read" : "write",
+                  (entry->cmd & SWD_CMD_A32) >> 1,
+                  data);
+
+        if (ack != SWD_ACK_OK) {
+            queued_retval = ack == SWD_ACK_WAIT ? ERROR_WAIT : ERROR_FAIL;
+            goto skip;
+        } else if (is_read) {
+            int parity = buf_get_u32(ctx->rx_buffer.data, entry->rx_offset + 3 + 32, 1);
+
+            if (parity != parity_u32(data)) {
+                LOG_ERROR("SWD Read data parity mismatch");
+                queued_retval = ERROR_FAIL;
+                goto skip;
+            }
+
+            if (entry->dst != NULL)
+                *entry->dst = data;
+        }
+    }
+
+skip:
+    /* Nothing in here is of use once the queue is decoded, or abandoned. */
+    clear_sampled(ctx->tx_buffer.available);
+    ctx->tx_buffer.available = 0;
+    ctx->rx_buffer.available = 0;
+    ctx->rx_idx = 0;
+    swd_samples_queued = 0;
+    swd_bits_queued = 0;
+    swd_cmd_queue_length = 0;
+    retval = queued_retval;
+    queued_retval = ERROR_OK;
+
+    jtag_trace_end(&span);
+    return retval;
+}
+
+/*
+ * Make room for num_clocks more clocks plus the trailing idle cycles. A
+ * flush in the middle of the queue would drop the samples of the
+ * transactions before it, so run the whole queue instead.
+ */
+static int ftdi_friend_swd_reserve(int num_clocks)
+{
+    int needed = 2 * (num_clocks + 8);
+
+    if (needed > buffer_size) {
+        LOG_ERROR("ftdi_friend_buffer_size too small for %d SWD clocks",
+                  num_clocks);
+        return ERROR_FAIL;
+    }
+
+    if (buffer_size - ctx->tx_buffer.available < needed) {
+        return ftdi_friend_swd_run_queue();
+    }
+    return ERROR_OK;
+}
+
+static void ftdi_friend_swd_queue_cmd(uint8_t cmd, uint32_t *dst, uint32_t data,
+                                      uint32_t ap_delay_clk)
+{
+    /* cmd, trn, ack, trn, data, parity and the idle cycles */
+    int retval = ftdi_friend_swd_reserve(8 + 1 + 3 + 1 + 32 + 1 + ap_delay_clk);
+    if (retval != ERROR_OK) {
+        queued_retval = retval;
+    }
+
+    if (swd_cmd_queue_length >= swd_cmd_queue_alloced) {
+        struct swd_cmd_queue_entry *q = realloc(swd_cmd_queue,
+            swd_cmd_queue_alloced * 2 * sizeof(*swd_cmd_queue));
+        if (q == NULL) {
+            queued_retval = ftdi_friend_swd_run_queue();
+        } else {
+            swd_cmd_queue = q;
+            swd_cmd_queue_alloced *= 2;
+            LOG_DEBUG("Increased SWD command queue to %zu elements",
+                      swd_cmd_queue_alloced);
+        }
+    }
+
+    if (queued_retval != ERROR_OK) return;
+
+    size_t i = swd_cmd_queue_length++;
+    swd_cmd_queue[i].cmd = cmd | SWD_CMD_START | SWD_CMD_PARK;
+    swd_cmd_queue[i].dst = dst;
+
+    swd_clock_bits(&swd_cmd_queue[i].cmd, 0, 8, 0);
+
+    /* trn */
+    swd_clock_bits(NULL, 0, 1, 0);
+    swd_cmd_queue[i].rx_offset = swd_samples_queued;
+
+    if (swd_cmd_queue[i].cmd & SWD_CMD_RnW) {
+        /* ack, data, parity, trn */
+        swd_clock_bits(NULL, 0, 3 + 32 + 1, 1);
+        swd_clock_bits(NULL, 0, 1, 0);
+    } else {
+        /* ack, trn, data, parity */
+        uint8_t data_parity[DIV_ROUND_UP(32 + 1, 8)];
+
+        buf_set_u32(data_parity, 0, 32, data);
+        buf_set_u32(data_parity, 32, 1, parity_u32(data));
+
+        swd_clock_bits(NULL, 0, 3, 1);
+        swd_clock_bits(NULL, 0, 1, 0);
+        swd_clock_bits(data_parity, 0, 32 + 1, 0);
+    }
+
+    /* Insert idle cycles after AP accesses to avoid WAIT */
+    if (cmd & SWD_CMD_APnDP)
+        swd_clock_bits(NULL, 0, ap_delay_clk, 0);
+}
+
+static void ftdi_friend_swd_read_reg(uint8_t cmd, uint32_t *value,
+                                     uint32_t ap_delay_clk)
+{
+    assert(cmd & SWD_CMD_RnW);
+    ftdi_friend_swd_queue_cmd(cmd, value, 0, ap_delay_clk);
+}
+
+static void ftdi_friend_swd_write_reg(uint8_t cmd, uint32_t value,
+                                      uint32_t ap_delay_clk)
+{
+    assert(!(cmd & SWD_CMD_RnW));
+    ftdi_friend_swd_queue_cmd(cmd, NULL, value, ap_delay_clk);
+}
+
+/* SWCLK rate last set through ftdi_friend_swd_frequency(), 0 if none */
+static int_least32_t swd_frequency_hz;
+
+static int_least32_t ftdi_friend_swd_frequency(int_least32_t hz)
+{
+    if (hz <= 0 || !ctx || !ctx->ftdi) {
+        return swd_frequency_hz ? swd_frequency_hz : (int_least32_t)jtag_get_speed_khz() * 1000;
+    }
+
+    /* Like the JTAG speed, SWCLK is set through the baud rate in whole kHz. */
+    int khz = MAX(hz / 1000, 1);
+    ftdi_friend_speed(khz);
+    swd_frequency_hz = khz * 1000;
+    return swd_frequency_hz;
+}
+
+static int ftdi_friend_swd_switch_seq(enum swd_special_seq seq)
+{
+    /* The dormant sequences aren't supported, so this covers the longest. */
+    int retval = ftdi_friend_swd_reserve(swd_seq_jtag_to_swd_len);
+    if (retval != ERROR_OK) return retval;
+
+    switch (seq) {
+    case LINE_RESET:
+        LOG_DEBUG("SWD line reset");
+        swd_clock_bits(swd_seq_line_reset, 0, swd_seq_line_reset_len, 0);
+        break;
+    case JTAG_TO_SWD:
+        LOG_DEBUG("JTAG-to-SWD");
+        swd_clock_bits(swd_seq_jtag_to_swd, 0, swd_seq_jtag_to_swd_len, 0);
+        break;
+    case SWD_TO_JTAG:
+        LOG_DEBUG("SWD-to-JTAG");
+        swd_clock_bits(swd_seq_swd_to_jtag, 0, swd_seq_swd_to_jtag_len, 0);
+        break;
+    default:
+        LOG_ERROR("Sequence %d not supported", seq);
+        return ERROR_FAIL;
+    }
+
+    return ERROR_OK;
+}
+
+static const struct swd_driver ftdi_friend_swd = {
+    .init = ftdi_friend_swd_init,
+    .frequency = ftdi_friend_swd_frequency,
+    .switch_seq = ftdi_friend_swd_switch_seq,
+    .read_reg = ftdi_friend_swd_read_reg,
+    .write_reg = ftdi_friend_swd_write_reg,
+    .run = ftdi_friend_swd_run_queue,
 };
 
+#if defined(HAVE_LIBFTDI1) && defined(HAVE_LIBUSB_GET_PORT_NUMBERS)
+/* libftdi1 hands out libusb-1.0 devices, see device_location_equal() in mpsse.c */
+static bool device_location_equal(struct libusb_device *device, const char *location)
+{
+    bool result = false;
+    char *loc = strdup(location);
+    uint8_t port_path[7];
+    int path_step, path_len;
+    uint8_t dev_bus = libusb_get_bus_number(device);
+    char *ptr;
+
+    path_len = libusb_get_port_numbers(device, port_path, 7);
+    if (path_len == LIBUSB_ERROR_OVERFLOW) {
+        LOG_ERROR("cannot determine path to usb device! (more than 7 ports in path)");
+        goto done;
+    }
+
+    ptr = strtok(loc, ":");
+    if (ptr == NULL || atoi(ptr) != dev_bus) {
+        goto done;
+    }
+
+    for (path_step = 0; path_step < 7; ++path_step) {
+        ptr = strtok(NULL, ",");
+        if (ptr == NULL) break;
+        if (path_step < path_len && atoi(ptr) != port_path[path_step]) break;
+    }
+
+    /* walked the full path, all elements match */
+    result = path_step == path_len;
+
+done:
+    free(loc);
+    return result;
+}
+#endif
+
+/*
+ * Open the first FTDI Friend that matches ftdi_friend_serial and
+ * ftdi_friend_location, if they are set.
+ */
+static int open_matching_device(void)
+{
+    struct ftdi_device_list *devices;
+    int count = ftdi_usb_find_all(ctx->ftdi, &devices,
+                                  ftdi_friend_vid, ftdi_friend_pid);
+    if (count < 0) {
+        return on_ftdi_error("ftdi_usb_find_all");
+    }
+
+    int rc = -1;
+    for (struct ftdi_device_list *dev = devices; dev; dev = dev->next) {
+#if defined(HAVE_LIBFTDI1) && defined(HAVE_LIBUSB_GET_PORT_NUMBERS)
+        if (ftdi_friend_location &&
+            !device_location_equal(dev->dev, ftdi_friend_location)) {
+            continue;
+        }
+#endif
+
+        if (ftdi_friend_serial) {
+            char serial[256];
+            if (ftdi_usb_get_strings(ctx->ftdi, dev->dev, NULL, 0, NULL, 0,
+                                     serial, sizeof(serial)) < 0) {
+                LOG_WARNING("libftdi call failed: ftdi_usb_get_strings: %s",
+                            ftdi_get_error_string(ctx->ftdi));
+                continue;
+            }
+            if (strcmp(serial, ftdi_friend_serial) != 0) continue;
+        }
+
+        rc = ftdi_usb_open_dev(ctx->ftdi, dev->dev);
+        break;
+    }
+
+    ftdi_list_free(&devices);
+
+    if (rc == -1) {
+        LOG_ERROR("no matching FTDI Friend found");
+        ftdi_free(ctx->ftdi);
+        ctx->ftdi = NULL;
+        return ERROR_FAIL;
+    }
+    if (rc < 0) {
+        return on_ftdi_error("ftdi_usb_open_dev");
+    }
+    return ERROR_OK;
+}
+
+/* undo what ftdi_friend_init() did before failing */
+static int init_failed(void)
+{
+    free_buffers();
+    if (ctx->ftdi) {
+        /* closes the device too, if it was opened */
+        ftdi_free(ctx->ftdi);
+    }
+    free(ctx);
+    ctx = NULL;
+    return ERROR_FAIL;
+}
+
 static int ftdi_friend_init(void)
 {
-    if ((ftdi = ftdi_new()) == 0) {
-        LOG_ERROR("ftdi_new failed");
+    ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        LOG_ERROR("failed to allocate the ftdi_friend context");
         return ERROR_FAIL;
     }
 
-    if (ftdi_usb_open(ftdi, ftdi_friend_vid, ftdi_friend_pid)) {
-        return on_ftdi_error("ftdi_usb_open");
+    if ((ctx->ftdi = ftdi_new()) == 0) {
+        LOG_ERROR("ftdi_new failed");
+        return init_failed();
     }
 
-    if (ftdi_set_bitmode(ftdi, ftdi_output_mask, BITMODE_SYNCBB)) {
-        return on_ftdi_error("ftdi_set_bitmode");
+    if (open_matching_device() != ERROR_OK) {
+        return init_failed();
     }
 
-    if ( ftdi_set_latency_timer(ftdi, latency_timer)) {
-        return on_ftdi_error("ftdi_set_latency_timer");
+    if (ftdi_set_bitmode(ctx->ftdi, ftdi_output_mask, BITMODE_SYNCBB)) {
+        on_ftdi_error("ftdi_set_bitmode");
+        return init_failed();
     }
 
-    if (ftdi_set_baudrate(ftdi, jtag_get_speed_khz())) {
-        return on_ftdi_error("ftdi_set_baudrate");
+    if ( ftdi_set_latency_timer(ctx->ftdi, latency_timer)) {
+        on_ftdi_error("ftdi_set_latency_timer");
+        return init_failed();
+    }
+
+    if (ftdi_set_baudrate(ctx->ftdi, jtag_get_speed_khz())) {
+        on_ftdi_error("ftdi_set_baudrate");
+        return init_failed();
+    }
+
+    if (alloc_buffers() != ERROR_OK) {
+        return init_failed();
+    }
+
+    if (auto_frame_size) {
+        if (measure_latency() != ERROR_OK) {
+            return init_failed();
+        }
+        update_frame_size(jtag_get_speed_khz());
     }
 
+    build_scan_templates();
     bitq_interface = &ftdi_friend_bitq;
     return ERROR_OK;
 }
 
 
-static const char * const ftdi_friend_transports[] = { NULL };
+static const char * const ftdi_friend_transports[] = { "jtag", "swd", NULL };
 
 struct jtag_interface ftdi_friend_interface = {
     .name = "ftdi_friend",
     .commands = ftdi_friend_command_handlers,
-    .transports = jtag_only,
+    .transports = ftdi_friend_transports,
+    .swd = &ftdi_friend_swd,
 
     .init = ftdi_friend_init,
     .quit = ftdi_friend_quit,
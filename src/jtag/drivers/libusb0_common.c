@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 #include "log.h"
+#include <jtag/jtag.h>
 #include "libusb0_common.h"
 
 static bool jtag_libusb_match(struct jtag_libusb_device *dev,
@@ -125,13 +126,19 @@ int jtag_libusb_control_transfer(jtag_libusb_device_handle *dev, uint8_t request
 int jtag_libusb_bulk_write(jtag_libusb_device_handle *dev, int ep, char *bytes,
 		int size, int timeout)
 {
-	return usb_bulk_write(dev, ep, bytes, size, timeout);
+	int transferred = usb_bulk_write(dev, ep, bytes, size, timeout);
+
+	jtag_count_usb_transfers(1, transferred > 0 ? transferred : 0);
+	return transferred;
 }
 
 int jtag_libusb_bulk_read(jtag_libusb_device_handle *dev, int ep, char *bytes,
 		int size, int timeout)
 {
-	return usb_bulk_read(dev, ep, bytes, size, timeout);
+	int transferred = usb_bulk_read(dev, ep, bytes, size, timeout);
+
+	jtag_count_usb_transfers(1, transferred > 0 ? transferred : 0);
+	return transferred;
 }
 
 int jtag_libusb_set_configuration(jtag_libusb_device_handle *devh,
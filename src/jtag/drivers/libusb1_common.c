@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 #include "log.h"
+#include <jtag/jtag.h>
 #include "libusb1_common.h"
 
 static struct libusb_context *jtag_libusb_context; /**< Libusb context **/
@@ -143,6 +144,7 @@ int jtag_libusb_bulk_write(jtag_libusb_device_handle *dev, int ep, char *bytes,
 
 	libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
 			     &transferred, timeout);
+	jtag_count_usb_transfers(1, transferred);
 	return transferred;
 }
 
@@ -153,6 +155,7 @@ int jtag_libusb_bulk_read(jtag_libusb_device_handle *dev, int ep, char *bytes,
 
 	libusb_bulk_transfer(dev, ep, (unsigned char *)bytes, size,
 			     &transferred, timeout);
+	jtag_count_usb_transfers(1, transferred);
 	return transferred;
 }
 
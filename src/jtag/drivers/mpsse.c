@@ -22,6 +22,7 @@
 
 #include "mpsse.h"
 #include "helper/log.h"
+#include "jtag/jtag.h"
 #include <libusb.h>
 
 /* Compatibility define for older libusb-1.0 */
@@ -786,6 +787,8 @@ static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 	struct transfer_result *res = transfer->user_data;
 	struct mpsse_ctx *ctx = res->ctx;
 
+	jtag_count_usb_transfers(0, transfer->actual_length);
+
 	unsigned packet_size = ctx->max_packet_size;
 
 	DEBUG_PRINT_BUF(transfer->buffer, transfer->actual_length);
@@ -814,9 +817,11 @@ static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 	DEBUG_IO("raw chunk %d, transferred %d of %d", transfer->actual_length, res->transferred,
 		ctx->read_count);
 
-	if (!res->done)
+	if (!res->done) {
+		jtag_count_usb_transfers(1, 0);
 		if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS)
 			res->done = true;
+	}
 }
 
 static LIBUSB_CALL void write_cb(struct libusb_transfer *transfer)
@@ -824,6 +829,7 @@ static LIBUSB_CALL void write_cb(struct libusb_transfer *transfer)
 	struct transfer_result *res = transfer->user_data;
 	struct mpsse_ctx *ctx = res->ctx;
 
+	jtag_count_usb_transfers(0, transfer->actual_length);
 	res->transferred += transfer->actual_length;
 
 	DEBUG_IO("transferred %d of %d", res->transferred, ctx->write_count);
@@ -835,6 +841,7 @@ static LIBUSB_CALL void write_cb(struct libusb_transfer *transfer)
 	else {
 		transfer->length = ctx->write_count - res->transferred;
 		transfer->buffer = ctx->write_buffer + res->transferred;
+		jtag_count_usb_transfers(1, 0);
 		if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS)
 			res->done = true;
 	}
@@ -858,6 +865,9 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 	if (ctx->write_count == 0)
 		return retval;
 
+	struct jtag_trace_span span;
+	jtag_trace_begin(&span, JTAG_TRACE_MPSSE);
+
 	struct libusb_transfer *read_transfer = 0;
 	struct transfer_result read_result = { .ctx = ctx, .done = true };
 	if (ctx->read_count) {
@@ -871,6 +881,7 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 	struct libusb_transfer *write_transfer = libusb_alloc_transfer(0);
 	libusb_fill_bulk_transfer(write_transfer, ctx->usb_dev, ctx->out_ep, ctx->write_buffer,
 		ctx->write_count, write_cb, &write_result, ctx->usb_write_timeout);
+	jtag_count_usb_transfers(1, 0);
 	retval = libusb_submit_transfer(write_transfer);
 	if (retval != LIBUSB_SUCCESS)
 		goto error_check;
@@ -880,6 +891,7 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 		libusb_fill_bulk_transfer(read_transfer, ctx->usb_dev, ctx->in_ep, ctx->read_chunk,
 			ctx->read_chunk_size, read_cb, &read_result,
 			ctx->usb_read_timeout);
+		jtag_count_usb_transfers(1, 0);
 		retval = libusb_submit_transfer(read_transfer);
 		if (retval != LIBUSB_SUCCESS)
 			goto error_check;
@@ -942,5 +954,6 @@ error_check:
 	if (retval != ERROR_OK)
 		mpsse_purge(ctx);
 
+	jtag_trace_end(&span);
 	return retval;
 }
@@ -571,6 +571,65 @@ void jtag_execute_queue_noclear(void);
 
 /** @returns the number of times the scan queue has been flushed */
 int jtag_get_flush_queue_count(void);
+/**
+ * Transports that flush the adapter queue without jtag_execute_queue(),
+ * like SWD, report each flush through this.
+ */
+void jtag_count_queue_flush(void);
+
+/**
+ * Adapter drivers report the USB transfers they submit, and the bytes
+ * moved by them, through this, so that benchmarks and the adapter trace
+ * can show transfers per operation.
+ */
+void jtag_count_usb_transfers(unsigned count, unsigned bytes);
+/** @returns the number of USB transfers reported by the adapter driver */
+unsigned jtag_get_usb_transfer_count(void);
+
+/** Where an adapter trace record was taken, see jtag_trace_begin(). */
+enum jtag_trace_source {
+	JTAG_TRACE_QUEUE,	/* jtag_execute_queue() */
+	JTAG_TRACE_BITQ,	/* bitq_execute_queue() */
+	JTAG_TRACE_MPSSE,	/* mpsse_flush() */
+	JTAG_TRACE_SWD,		/* an SWD driver's run() */
+	JTAG_TRACE_NUM_SOURCES
+};
+
+/** One traced flush, in progress. */
+struct jtag_trace_span {
+	bool active;
+	enum jtag_trace_source source;
+	int64_t start_us;
+	/* filled in by the caller between begin and end, if known */
+	unsigned commands;
+	unsigned bits;
+	/* USB counters when the span started */
+	unsigned usb_transfers;
+	uint64_t usb_bytes;
+};
+
+/**
+ * Start timing a flush. This costs a flag test while the adapter trace is
+ * disabled, so drivers can leave the calls in their queue execution
+ * paths. The span must be passed to jtag_trace_end() when it's done.
+ */
+void jtag_trace_begin(struct jtag_trace_span *span, enum jtag_trace_source source);
+/** Add the commands and bits of a JTAG command list to a span. */
+struct jtag_command;
+void jtag_trace_count_queue(struct jtag_trace_span *span, const struct jtag_command *cmd);
+/** Finish a span and store it in the trace ring and latency histogram. */
+void jtag_trace_end(struct jtag_trace_span *span);
+
+void jtag_trace_enable(bool enable);
+bool jtag_trace_is_enabled(void);
+void jtag_trace_clear(void);
+const char *jtag_trace_source_name(enum jtag_trace_source source);
+/** Number of latency histogram buckets; bucket n counts flushes that took
+ * [2^n, 2^(n+1)) us, except bucket 0 that also counts shorter ones. */
+#define JTAG_TRACE_BUCKETS 24
+const uint32_t *jtag_trace_histogram(enum jtag_trace_source source);
+/** Write the trace ring, oldest record first, as CSV. */
+int jtag_trace_dump(const char *filename);
 
 /** Report Tcl event to all TAPs */
 void jtag_notify_event(enum jtag_event);
@@ -831,6 +831,19 @@ COMMAND_HANDLER(handle_jtag_init_command)
 	return jtag_init(CMD_CTX);
 }
 
+COMMAND_HANDLER(handle_jtag_queue_stats_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	struct cmd_queue_stats stats;
+	cmd_queue_get_stats(&stats);
+
+	command_print(CMD_CTX, "pages %u bytes %zu peak_bytes %zu page_allocs %u resets %u",
+		stats.pages, stats.bytes, stats.peak_bytes, stats.page_allocs, stats.resets);
+	return ERROR_OK;
+}
+
 static const struct command_registration jtag_subcommand_handlers[] = {
 	{
 		.name = "init",
@@ -913,6 +926,14 @@ static const struct command_registration jtag_subcommand_handlers[] = {
 		.jim_handler = jim_jtag_names,
 		.help = "Returns list of all JTAG tap names.",
 	},
+	{
+		.name = "queue_stats",
+		.mode = COMMAND_ANY,
+		.handler = handle_jtag_queue_stats_command,
+		.help = "Print allocation counters of the JTAG command queue "
+			"as key/value pairs.",
+		.usage = "",
+	},
 	{
 		.chain = jtag_command_handlers_to_move,
 	},
@@ -161,7 +161,7 @@ static int ChibiOS_update_memory_signature(struct rtos *rtos)
 		return -1;
 	}
 
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 								rtos->symbols[ChibiOS_VAL_ch_debug].address,
 								sizeof(*signature),
 								(uint8_t *) signature);
@@ -316,7 +316,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 	current = rlist;
 	previous = rlist;
 	while (1) {
-		retval = target_read_u32(rtos->target,
+		retval = rtos_read_u32(rtos,
 								 current + signature->cf_off_newer, &current);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read next ChibiOS thread");
@@ -331,7 +331,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 			break;
 		}
 		/* Fetch previous thread in the list as a integrity check. */
-		retval = target_read_u32(rtos->target,
+		retval = rtos_read_u32(rtos,
 								 current + signature->cf_off_older, &older);
 		if ((retval != ERROR_OK) || (older == 0) || (older != previous)) {
 			LOG_ERROR("ChibiOS registry integrity check failed, "
@@ -386,7 +386,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		uint32_t name_ptr = 0;
 		char tmp_str[CHIBIOS_THREAD_NAME_STR_SIZE];
 
-		retval = target_read_u32(rtos->target,
+		retval = rtos_read_u32(rtos,
 								 current + signature->cf_off_newer, &current);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read next ChibiOS thread");
@@ -401,7 +401,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		curr_thrd_details->threadid = current;
 
 		/* read the name pointer */
-		retval = target_read_u32(rtos->target,
+		retval = rtos_read_u32(rtos,
 								 current + signature->cf_off_name, &name_ptr);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Could not read ChibiOS thread name pointer from target");
@@ -409,7 +409,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		}
 
 		/* Read the thread name */
-		retval = target_read_buffer(rtos->target, name_ptr,
+		retval = rtos_read_buffer(rtos, name_ptr,
 									CHIBIOS_THREAD_NAME_STR_SIZE,
 									(uint8_t *)&tmp_str);
 		if (retval != ERROR_OK) {
@@ -429,7 +429,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 		uint8_t threadState;
 		const char *state_desc;
 
-		retval = target_read_u8(rtos->target,
+		retval = rtos_read_u8(rtos,
 								current + signature->cf_off_state, &threadState);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Error reading thread state from ChibiOS target");
@@ -453,7 +453,7 @@ static int ChibiOS_update_threads(struct rtos *rtos)
 
 	uint32_t current_thrd;
 	/* NOTE: By design, cf_off_name equals readylist_current_offset */
-	retval = target_read_u32(rtos->target,
+	retval = rtos_read_u32(rtos,
 							 rlist + signature->cf_off_name,
 							 &current_thrd);
 	if (retval != ERROR_OK) {
@@ -489,7 +489,7 @@ static int ChibiOS_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, cha
 	}
 
 	/* Read the stack pointer */
-	retval = target_read_u32(rtos->target,
+	retval = rtos_read_u32(rtos,
 							 thread_id + param->signature->cf_off_ctx, &stack_ptr);
 	if (retval != ERROR_OK) {
 		LOG_ERROR("Error reading stack frame from ChibiOS thread");
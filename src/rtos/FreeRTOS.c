@@ -177,7 +177,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 	}
 
 	int thread_list_size = 0;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[FreeRTOS_VAL_uxCurrentNumberOfTasks].address,
 			param->thread_count_width,
 			(uint8_t *)&thread_list_size);
@@ -194,7 +194,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 	rtos_free_threadlist(rtos);
 
 	/* read the current thread */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[FreeRTOS_VAL_pxCurrentTCB].address,
 			param->pointer_width,
 			(uint8_t *)&rtos->current_thread);
@@ -222,8 +222,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 		rtos->thread_details->threadid = 1;
 		rtos->thread_details->exists = true;
 		rtos->thread_details->extra_info_str = NULL;
-		rtos->thread_details->thread_name_str = malloc(sizeof(tmp_str));
-		strcpy(rtos->thread_details->thread_name_str, tmp_str);
+		rtos->thread_details->thread_name_str = rtos_thread_name_str(rtos, 1, tmp_str);
 
 		if (thread_list_size == 1) {
 			rtos->thread_count = 1;
@@ -245,7 +244,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 		return ERROR_FAIL;
 	}
 	int64_t max_used_priority = 0;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[FreeRTOS_VAL_uxTopUsedPriority].address,
 			param->pointer_width,
 			(uint8_t *)&max_used_priority);
@@ -285,7 +284,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 
 		/* Read the number of threads in this list */
 		int64_t list_thread_count = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				list_of_lists[i],
 				param->thread_count_width,
 				(uint8_t *)&list_thread_count);
@@ -303,7 +302,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 		/* Read the location of first list item */
 		uint64_t prev_list_elem_ptr = -1;
 		uint64_t list_elem_ptr = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				list_of_lists[i] + param->list_next_offset,
 				param->pointer_width,
 				(uint8_t *)&list_elem_ptr);
@@ -320,7 +319,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 				(tasks_found < thread_list_size)) {
 			/* Get the location of the thread structure. */
 			rtos->thread_details[tasks_found].threadid = 0;
-			retval = target_read_buffer(rtos->target,
+			retval = rtos_read_buffer(rtos,
 					list_elem_ptr + param->list_elem_content_offset,
 					param->pointer_width,
 					(uint8_t *)&(rtos->thread_details[tasks_found].threadid));
@@ -339,7 +338,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 			char tmp_str[FREERTOS_THREAD_NAME_STR_SIZE];
 
 			/* Read the thread name */
-			retval = target_read_buffer(rtos->target,
+			retval = rtos_read_buffer(rtos,
 					rtos->thread_details[tasks_found].threadid + param->thread_name_offset,
 					FREERTOS_THREAD_NAME_STR_SIZE,
 					(uint8_t *)&tmp_str);
@@ -357,16 +356,14 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 				strcpy(tmp_str, "No Name");
 
 			rtos->thread_details[tasks_found].thread_name_str =
-				malloc(strlen(tmp_str)+1);
-			strcpy(rtos->thread_details[tasks_found].thread_name_str, tmp_str);
+				rtos_thread_name_str(rtos, rtos->thread_details[tasks_found].threadid, tmp_str);
 			rtos->thread_details[tasks_found].exists = true;
 
 			if (rtos->thread_details[tasks_found].threadid == rtos->current_thread) {
 				char running_str[] = "State: Running";
-				rtos->thread_details[tasks_found].extra_info_str = malloc(
-						sizeof(running_str));
-				strcpy(rtos->thread_details[tasks_found].extra_info_str,
-					running_str);
+				rtos->thread_details[tasks_found].extra_info_str =
+					rtos_thread_extra_info_str(rtos,
+						rtos->thread_details[tasks_found].threadid, running_str);
 			} else
 				rtos->thread_details[tasks_found].extra_info_str = NULL;
 
@@ -375,7 +372,7 @@ static int FreeRTOS_update_threads(struct rtos *rtos)
 
 			prev_list_elem_ptr = list_elem_ptr;
 			list_elem_ptr = 0;
-			retval = target_read_buffer(rtos->target,
+			retval = rtos_read_buffer(rtos,
 					prev_list_elem_ptr + param->list_elem_next_offset,
 					param->pointer_width,
 					(uint8_t *)&list_elem_ptr);
@@ -414,7 +411,7 @@ static int FreeRTOS_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, ch
 	param = (const struct FreeRTOS_params *) rtos->rtos_specific_params;
 
 	/* Read the stack pointer */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			thread_id + param->thread_stack_offset,
 			param->pointer_width,
 			(uint8_t *)&stack_ptr);
@@ -451,7 +448,7 @@ static int FreeRTOS_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, ch
 	if (cm4_fpu_enabled == 1) {
 		/* Read the LR to decide between stacking with or without FPU */
 		uint32_t LR_svc = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				stack_ptr + 0x20,
 				param->pointer_width,
 				(uint8_t *)&LR_svc);
@@ -508,7 +505,7 @@ static int FreeRTOS_get_thread_ascii_info(struct rtos *rtos, threadid_t thread_i
 	char tmp_str[FREERTOS_THREAD_NAME_STR_SIZE];
 
 	/* Read the thread name */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			thread_id + param->thread_name_offset,
 			FREERTOS_THREAD_NAME_STR_SIZE,
 			(uint8_t *)&tmp_str);
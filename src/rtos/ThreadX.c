@@ -284,7 +284,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 	}
 
 	/* read the number of threads */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[ThreadX_VAL_tx_thread_created_count].address,
 			4,
 			(uint8_t *)&thread_list_size);
@@ -298,7 +298,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 	rtos_free_threadlist(rtos);
 
 	/* read the current thread id */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[ThreadX_VAL_tx_thread_current_ptr].address,
 			4,
 			(uint8_t *)&rtos->current_thread);
@@ -335,7 +335,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 
 	/* Read the pointer to the first thread */
 	int64_t thread_ptr = 0;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[ThreadX_VAL_tx_thread_created_ptr].address,
 			param->pointer_width,
 			(uint8_t *)&thread_ptr);
@@ -357,7 +357,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 		rtos->thread_details[tasks_found].threadid = thread_ptr;
 
 		/* read the name pointer */
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_ptr + param->thread_name_offset,
 				param->pointer_width,
 				(uint8_t *)&name_ptr);
@@ -368,7 +368,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 
 		/* Read the thread name */
 		retval =
-			target_read_buffer(rtos->target,
+			rtos_read_buffer(rtos,
 				name_ptr,
 				THREADX_THREAD_NAME_STR_SIZE,
 				(uint8_t *)&tmp_str);
@@ -387,7 +387,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 
 		/* Read the thread status */
 		int64_t thread_status = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_ptr + param->thread_state_offset,
 				4,
 				(uint8_t *)&thread_status);
@@ -418,7 +418,7 @@ static int ThreadX_update_threads(struct rtos *rtos)
 
 		/* Get the location of the next thread structure. */
 		thread_ptr = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				prev_thread_ptr + param->thread_next_offset,
 				param->pointer_width,
 				(uint8_t *) &thread_ptr);
@@ -453,7 +453,7 @@ static int ThreadX_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, cha
 
 	/* Read the stack pointer */
 	int64_t stack_ptr = 0;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			thread_id + param->thread_stack_offset,
 			param->pointer_width,
 			(uint8_t *)&stack_ptr);
@@ -541,7 +541,7 @@ static int ThreadX_get_thread_detail(struct rtos *rtos,
 
 	int64_t name_ptr = 0;
 	/* read the name pointer */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			thread_id + param->thread_name_offset,
 			param->pointer_width,
 			(uint8_t *)&name_ptr);
@@ -551,7 +551,7 @@ static int ThreadX_get_thread_detail(struct rtos *rtos,
 	}
 
 	/* Read the thread name */
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			name_ptr,
 			THREADX_THREAD_NAME_STR_SIZE,
 			(uint8_t *)&tmp_str);
@@ -569,7 +569,7 @@ static int ThreadX_get_thread_detail(struct rtos *rtos,
 	/* Read the thread status */
 	int64_t thread_status = 0;
 	retval =
-		target_read_buffer(rtos->target,
+		rtos_read_buffer(rtos,
 			thread_id + param->thread_state_offset,
 			4,
 			(uint8_t *)&thread_status);
@@ -128,14 +128,14 @@ static int eCos_update_threads(struct rtos *rtos)
 	/* determine the number of current threads */
 	uint32_t thread_list_head = rtos->symbols[eCos_VAL_thread_list].address;
 	uint32_t thread_index;
-	target_read_buffer(rtos->target,
+	rtos_read_buffer(rtos,
 		thread_list_head,
 		param->pointer_width,
 		(uint8_t *) &thread_index);
 	uint32_t first_thread = thread_index;
 	do {
 		thread_list_size++;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_next_offset,
 				param->pointer_width,
 				(uint8_t *) &thread_index);
@@ -145,14 +145,14 @@ static int eCos_update_threads(struct rtos *rtos)
 
 	/* read the current thread id */
 	uint32_t current_thread_addr;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			rtos->symbols[eCos_VAL_current_thread_ptr].address,
 			4,
 			(uint8_t *)&current_thread_addr);
 	if (retval != ERROR_OK)
 		return retval;
 	rtos->current_thread = 0;
-	retval = target_read_buffer(rtos->target,
+	retval = rtos_read_buffer(rtos,
 			current_thread_addr + param->thread_uniqueid_offset,
 			2,
 			(uint8_t *)&rtos->current_thread);
@@ -198,7 +198,7 @@ static int eCos_update_threads(struct rtos *rtos)
 
 		/* Save the thread pointer */
 		uint16_t thread_id;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_uniqueid_offset,
 				2,
 				(uint8_t *)&thread_id);
@@ -209,7 +209,7 @@ static int eCos_update_threads(struct rtos *rtos)
 		rtos->thread_details[tasks_found].threadid = thread_id;
 
 		/* read the name pointer */
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_name_offset,
 				param->pointer_width,
 				(uint8_t *)&name_ptr);
@@ -220,7 +220,7 @@ static int eCos_update_threads(struct rtos *rtos)
 
 		/* Read the thread name */
 		retval =
-			target_read_buffer(rtos->target,
+			rtos_read_buffer(rtos,
 				name_ptr,
 				ECOS_THREAD_NAME_STR_SIZE,
 				(uint8_t *)&tmp_str);
@@ -239,7 +239,7 @@ static int eCos_update_threads(struct rtos *rtos)
 
 		/* Read the thread status */
 		int64_t thread_status = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_state_offset,
 				4,
 				(uint8_t *)&thread_status);
@@ -271,7 +271,7 @@ static int eCos_update_threads(struct rtos *rtos)
 
 		/* Get the location of the next thread structure. */
 		thread_index = rtos->symbols[eCos_VAL_thread_list].address;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				prev_thread_ptr + param->thread_next_offset,
 				param->pointer_width,
 				(uint8_t *) &thread_index);
@@ -307,11 +307,11 @@ static int eCos_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, char *
 	uint16_t id = 0;
 	uint32_t thread_list_head = rtos->symbols[eCos_VAL_thread_list].address;
 	uint32_t thread_index;
-	target_read_buffer(rtos->target, thread_list_head, param->pointer_width,
+	rtos_read_buffer(rtos, thread_list_head, param->pointer_width,
 			(uint8_t *)&thread_index);
 	bool done = false;
 	while (!done) {
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_uniqueid_offset,
 				2,
 				(uint8_t *)&id);
@@ -324,7 +324,7 @@ static int eCos_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, char *
 			done = true;
 			break;
 		}
-		target_read_buffer(rtos->target,
+		rtos_read_buffer(rtos,
 			thread_index + param->thread_next_offset,
 			param->pointer_width,
 			(uint8_t *) &thread_index);
@@ -333,7 +333,7 @@ static int eCos_get_thread_reg_list(struct rtos *rtos, int64_t thread_id, char *
 	if (done) {
 		/* Read the stack pointer */
 		int64_t stack_ptr = 0;
-		retval = target_read_buffer(rtos->target,
+		retval = rtos_read_buffer(rtos,
 				thread_index + param->thread_stack_offset,
 				param->pointer_width,
 				(uint8_t *)&stack_ptr);
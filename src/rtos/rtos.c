@@ -84,6 +84,9 @@ static void os_free(struct target *target)
 	if (target->rtos->symbols)
 		free(target->rtos->symbols);
 
+	free(target->rtos->read_cache);
+	free(target->rtos->thread_list_xml);
+
 	free(target->rtos);
 	target->rtos = NULL;
 }
@@ -338,7 +341,7 @@ int rtos_thread_packet(struct connection *connection, char const *packet, int pa
 		if (rtos_qsymbol(connection, packet, packet_size) == 1) {
 			target->rtos_auto_detect = false;
 			target->rtos->type->create(target);
-			target->rtos->type->update_threads(target->rtos);
+			rtos_update_threads(target);
 		}
 		return ERROR_OK;
 	} else if (strncmp(packet, "qfThreadInfo", 12) == 0) {
@@ -540,27 +543,289 @@ int rtos_try_next(struct target *target)
 	return 1;
 }
 
+/* Walking the thread lists takes many small, dependent reads of TCBs and
+ * list nodes.  While update_threads() runs, rtos_read_buffer() fetches
+ * whole aligned blocks around each access and serves later reads from
+ * them, so most of those round trips hit the cache.  The cache is dropped
+ * when the update finishes; nothing is kept across a resume.
+ */
+#define RTOS_READ_CACHE_BLOCK_SIZE	128
+#define RTOS_READ_CACHE_BLOCKS		128
+
+struct rtos_read_cache_block {
+	target_addr_t address;
+	uint8_t data[RTOS_READ_CACHE_BLOCK_SIZE];
+};
+
+static struct rtos_read_cache_block *rtos_read_cache_lookup(struct rtos *rtos,
+		target_addr_t address)
+{
+	for (int i = 0; i < rtos->read_cache_count; i++) {
+		if (rtos->read_cache[i].address == address)
+			return &rtos->read_cache[i];
+	}
+	return NULL;
+}
+
+static struct rtos_read_cache_block *rtos_read_cache_insert(struct rtos *rtos,
+		target_addr_t address, const uint8_t *data)
+{
+	struct rtos_read_cache_block *block;
+
+	if (rtos->read_cache_count < RTOS_READ_CACHE_BLOCKS)
+		block = &rtos->read_cache[rtos->read_cache_count++];
+	else {
+		/* full, replace blocks round robin */
+		block = &rtos->read_cache[rtos->read_cache_next];
+		rtos->read_cache_next = (rtos->read_cache_next + 1) % RTOS_READ_CACHE_BLOCKS;
+	}
+
+	block->address = address;
+	memcpy(block->data, data, RTOS_READ_CACHE_BLOCK_SIZE);
+
+	return block;
+}
+
+int rtos_read_buffer(struct rtos *rtos, target_addr_t address, uint32_t size, uint8_t *buffer)
+{
+	if (!rtos->read_cache_active)
+		return target_read_buffer(rtos->target, address, size, buffer);
+
+	target_addr_t block_address = address & ~(target_addr_t)(RTOS_READ_CACHE_BLOCK_SIZE - 1);
+	target_addr_t end = address + size;
+
+	while (address < end) {
+		struct rtos_read_cache_block *block = rtos_read_cache_lookup(rtos, block_address);
+
+		if (block == NULL) {
+			/* fetch this and any following missing blocks in one go */
+			uint32_t count = 1;
+			while ((block_address + count * RTOS_READ_CACHE_BLOCK_SIZE < end) &&
+					(count < RTOS_READ_CACHE_BLOCKS) &&
+					!rtos_read_cache_lookup(rtos,
+						block_address + count * RTOS_READ_CACHE_BLOCK_SIZE))
+				count++;
+
+			uint8_t *data = malloc(count * RTOS_READ_CACHE_BLOCK_SIZE);
+			if (data == NULL)
+				return target_read_buffer(rtos->target, address, end - address, buffer);
+
+			if (target_read_buffer(rtos->target, block_address,
+					count * RTOS_READ_CACHE_BLOCK_SIZE, data) != ERROR_OK) {
+				/* the speculative read may run into unmapped memory,
+				 * retry with exactly what was asked for */
+				free(data);
+				return target_read_buffer(rtos->target, address, end - address, buffer);
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+				block = rtos_read_cache_insert(rtos,
+						block_address + i * RTOS_READ_CACHE_BLOCK_SIZE,
+						data + i * RTOS_READ_CACHE_BLOCK_SIZE);
+			free(data);
+
+			block = rtos_read_cache_lookup(rtos, block_address);
+			if (block == NULL)
+				return target_read_buffer(rtos->target, address, end - address, buffer);
+		}
+
+		uint32_t offset = address - block_address;
+		uint32_t chunk = RTOS_READ_CACHE_BLOCK_SIZE - offset;
+		if (chunk > end - address)
+			chunk = end - address;
+
+		memcpy(buffer, block->data + offset, chunk);
+		buffer += chunk;
+		address += chunk;
+		block_address += RTOS_READ_CACHE_BLOCK_SIZE;
+	}
+
+	return ERROR_OK;
+}
+
+int rtos_read_u32(struct rtos *rtos, target_addr_t address, uint32_t *value)
+{
+	uint8_t buf[4];
+	int retval = rtos_read_buffer(rtos, address, sizeof(buf), buf);
+
+	if (retval == ERROR_OK)
+		*value = target_buffer_get_u32(rtos->target, buf);
+
+	return retval;
+}
+
+int rtos_read_u8(struct rtos *rtos, target_addr_t address, uint8_t *value)
+{
+	return rtos_read_buffer(rtos, address, 1, value);
+}
+
+static void rtos_free_thread_details(struct thread_detail *details, int count)
+{
+	for (int j = 0; j < count; j++) {
+		free(details[j].thread_name_str);
+		free(details[j].extra_info_str);
+	}
+	free(details);
+}
+
+static bool rtos_str_equal(const char *a, const char *b)
+{
+	if ((a == NULL) || (b == NULL))
+		return a == b;
+	return strcmp(a, b) == 0;
+}
+
+/* Find a thread in the list of the previous update.  Backends usually
+ * report threads in the same order on every halt, so start looking right
+ * after the previous match.
+ */
+static struct thread_detail *rtos_prev_thread(struct rtos *rtos, threadid_t threadid)
+{
+	for (int i = 0; i < rtos->prev_thread_count; i++) {
+		int j = (rtos->prev_thread_hint + i) % rtos->prev_thread_count;
+
+		if (rtos->prev_thread_details[j].threadid == threadid) {
+			rtos->prev_thread_hint = j + 1;
+			return &rtos->prev_thread_details[j];
+		}
+	}
+	return NULL;
+}
+
+static char *rtos_reuse_str(struct rtos *rtos, char **prev, const char *str)
+{
+	char *result;
+
+	if ((prev != NULL) && (*prev != NULL) && (strcmp(*prev, str) == 0)) {
+		/* take over the string from the previous list */
+		result = *prev;
+		*prev = NULL;
+		rtos->prev_thread_strs_reused++;
+	} else {
+		result = strdup(str);
+		rtos->prev_thread_strs_allocated++;
+	}
+
+	return result;
+}
+
+/* Thread name and extra info strings for the list being built by
+ * update_threads(); unchanged strings are moved over from the previous
+ * list instead of being allocated again.
+ */
+char *rtos_thread_name_str(struct rtos *rtos, threadid_t threadid, const char *name)
+{
+	struct thread_detail *prev = rtos_prev_thread(rtos, threadid);
+
+	return rtos_reuse_str(rtos, prev ? &prev->thread_name_str : NULL, name);
+}
+
+char *rtos_thread_extra_info_str(struct rtos *rtos, threadid_t threadid, const char *info)
+{
+	struct thread_detail *prev = rtos_prev_thread(rtos, threadid);
+
+	return rtos_reuse_str(rtos, prev ? &prev->extra_info_str : NULL, info);
+}
+
+static bool rtos_thread_list_changed(struct rtos *rtos,
+		const struct thread_detail *prev, int prev_count)
+{
+	if ((rtos->thread_count != prev_count) || (rtos->thread_details == NULL))
+		return true;
+
+	/* a string that had to be allocated afresh is new or has changed */
+	if (rtos->prev_thread_strs_allocated)
+		return true;
+
+	for (int i = 0; i < prev_count; i++) {
+		const struct thread_detail *a = &rtos->thread_details[i];
+		const struct thread_detail *b = &prev[i];
+
+		if ((a->threadid != b->threadid) || (a->exists != b->exists))
+			return true;
+		/* strings reused through rtos_thread_*_str() were moved out of
+		 * the previous list, everything else is compared */
+		if (b->thread_name_str != NULL || !rtos->prev_thread_strs_reused) {
+			if (!rtos_str_equal(a->thread_name_str, b->thread_name_str))
+				return true;
+		}
+		if (b->extra_info_str != NULL || !rtos->prev_thread_strs_reused) {
+			if (!rtos_str_equal(a->extra_info_str, b->extra_info_str))
+				return true;
+		}
+	}
+
+	return false;
+}
+
 int rtos_update_threads(struct target *target)
 {
-	if ((target->rtos != NULL) && (target->rtos->type != NULL))
-		target->rtos->type->update_threads(target->rtos);
+	struct rtos *rtos = target->rtos;
+
+	if ((rtos == NULL) || (rtos->type == NULL))
+		return ERROR_OK;
+
+	if (rtos->read_cache == NULL)
+		rtos->read_cache = malloc(RTOS_READ_CACHE_BLOCKS * sizeof(struct rtos_read_cache_block));
+	rtos->read_cache_active = (rtos->read_cache != NULL);
+	rtos->read_cache_count = 0;
+	rtos->read_cache_next = 0;
+
+	/* Let the backend build its list next to the previous one, so that
+	 * strings can be reused and an unchanged list detected. */
+	struct thread_detail *prev = rtos->thread_details;
+	int prev_count = rtos->thread_count;
+	int64_t prev_threadid = rtos->current_threadid;
+	threadid_t prev_thread = rtos->current_thread;
+
+	if (prev != NULL) {
+		rtos->thread_details = NULL;
+		rtos->thread_count = 0;
+		rtos->current_threadid = -1;
+		rtos->current_thread = 0;
+	}
+	rtos->prev_thread_details = prev;
+	rtos->prev_thread_count = prev_count;
+	rtos->prev_thread_hint = 0;
+	rtos->prev_thread_strs_allocated = 0;
+	rtos->prev_thread_strs_reused = 0;
+
+	int retval = rtos->type->update_threads(rtos);
+
+	rtos->prev_thread_details = NULL;
+	rtos->prev_thread_count = 0;
+	rtos->read_cache_active = false;
+	rtos->read_cache_count = 0;
+
+	if ((retval != ERROR_OK) && (rtos->thread_details == NULL) && (prev != NULL)) {
+		/* the backend bailed out before building a new list, keep the old one */
+		rtos->thread_details = prev;
+		rtos->thread_count = prev_count;
+		rtos->current_threadid = prev_threadid;
+		rtos->current_thread = prev_thread;
+		return ERROR_OK;
+	}
+
+	if (rtos_thread_list_changed(rtos, prev, prev_count)) {
+		free(rtos->thread_list_xml);
+		rtos->thread_list_xml = NULL;
+	}
+
+	if (prev != NULL)
+		rtos_free_thread_details(prev, prev_count);
+
 	return ERROR_OK;
 }
 
 void rtos_free_threadlist(struct rtos *rtos)
 {
 	if (rtos->thread_details) {
-		int j;
-
-		for (j = 0; j < rtos->thread_count; j++) {
-			struct thread_detail *current_thread = &rtos->thread_details[j];
-			free(current_thread->thread_name_str);
-			free(current_thread->extra_info_str);
-		}
-		free(rtos->thread_details);
+		rtos_free_thread_details(rtos->thread_details, rtos->thread_count);
 		rtos->thread_details = NULL;
 		rtos->thread_count = 0;
 		rtos->current_threadid = -1;
 		rtos->current_thread = 0;
+		free(rtos->thread_list_xml);
+		rtos->thread_list_xml = NULL;
 	}
 }
@@ -26,6 +26,7 @@ typedef int64_t threadid_t;
 typedef int64_t symbol_address_t;
 
 struct reg;
+struct rtos_read_cache_block;
 
 /**
  * Table should be terminated by an element with NULL in symbol_name
@@ -55,6 +56,19 @@ struct rtos {
 	int thread_count;
 	int (*gdb_thread_packet)(struct connection *connection, char const *packet, int packet_size);
 	void *rtos_specific_params;
+	/* target memory read through rtos_read_buffer() while the thread
+	 * list is being updated */
+	struct rtos_read_cache_block *read_cache;
+	int read_cache_count;
+	int read_cache_next;
+	bool read_cache_active;
+	/* thread list of the previous update, while the new one is built */
+	struct thread_detail *prev_thread_details;
+	int prev_thread_count;
+	int prev_thread_hint;
+	int prev_thread_strs_allocated;
+	int prev_thread_strs_reused;
+	char *thread_list_xml;	/* qXfer:threads document for the current list */
 };
 
 struct rtos_type {
@@ -103,7 +117,12 @@ int rtos_try_next(struct target *target);
 int gdb_thread_packet(struct connection *connection, char const *packet, int packet_size);
 int rtos_get_gdb_reg_list(struct connection *connection);
 int rtos_update_threads(struct target *target);
+int rtos_read_buffer(struct rtos *rtos, target_addr_t address, uint32_t size, uint8_t *buffer);
+int rtos_read_u32(struct rtos *rtos, target_addr_t address, uint32_t *value);
+int rtos_read_u8(struct rtos *rtos, target_addr_t address, uint8_t *value);
 void rtos_free_threadlist(struct rtos *rtos);
+char *rtos_thread_name_str(struct rtos *rtos, threadid_t threadid, const char *name);
+char *rtos_thread_extra_info_str(struct rtos *rtos, threadid_t threadid, const char *info);
 int rtos_smp_init(struct target *target);
 /*  function for handling symbol access */
 int rtos_qsymbol(struct connection *connection, char const *packet, int packet_size);
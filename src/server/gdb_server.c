@@ -63,6 +63,29 @@ struct target_desc_format {
 	uint32_t tdesc_length;
 };
 
+/* Memory read cache, lines of GDB_MEM_CACHE_LINE_SIZE bytes, direct mapped.
+ * A miss reads the whole line, which prefetches the bytes around GDB's
+ * request. */
+#define GDB_MEM_CACHE_LINE_SIZE	64
+#define GDB_MEM_CACHE_LINES	256
+
+/* most log output collected for one O packet, which is hex encoded */
+#define GDB_LOG_BUFFER_SIZE	((GDB_BUFFER_SIZE - 2) / 2)
+
+struct gdb_mem_cache_line {
+	bool valid;
+	bool flash;	/* line lies in a flash bank and survives resume */
+	target_addr_t address;
+	uint8_t data[GDB_MEM_CACHE_LINE_SIZE];
+};
+
+struct gdb_mem_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t uncached;
+	uint64_t invalidations;
+};
+
 /* private connection data for GDB */
 struct gdb_connection {
 	char buffer[GDB_BUFFER_SIZE];
@@ -71,6 +94,23 @@ struct gdb_connection {
 	int ctrl_c;
 	enum target_state frontend_state;
 	struct image *vflash_image;
+	/* With gdb_flash_streaming, vFlashWrite data is programmed as soon as
+	 * whole flash sectors have arrived. This holds the contiguous run that
+	 * hasn't been programmed yet. Like memory write errors, programming
+	 * errors are reported late, by vFlashDone. */
+	uint8_t *vflash_buf;
+	uint32_t vflash_addr;
+	uint32_t vflash_len;
+	bool vflash_started;
+	int vflash_retval;
+	struct gdb_mem_cache_line *mem_cache;
+	/* memory_write_count of the target when the cache was last checked */
+	uint32_t mem_cache_serial;
+	/* log output waiting to be sent as a single O packet */
+	char *log_buf;
+	int log_len;
+	/* a one-shot gdb_log_flush_callback() is registered for log_buf */
+	bool log_flush_pending;
 	int closed;
 	int busy;
 	int noack_mode;
@@ -109,6 +149,8 @@ static char *gdb_port_next;
 
 static void gdb_log_callback(void *priv, const char *file, unsigned line,
 		const char *function, const char *string);
+static int gdb_flush_log(struct connection *connection);
+static int gdb_log_flush_callback(void *priv);
 
 /* number of gdb connections, mainly to suppress gdb related debugging spam
  * in helper/log.c when no gdb connections are actually active */
@@ -120,6 +162,9 @@ int gdb_actual_connections;
 static int gdb_use_memory_map = 1;
 /* enabled by default*/
 static int gdb_flash_program = 1;
+/* program vFlashWrite data sector by sector as it arrives,
+ * disabled by default */
+static int gdb_flash_streaming;
 
 /* if set, data aborts cause an error to be reported in memory read packets
  * see the code in gdb_read_memory_packet() for further explanations.
@@ -127,6 +172,11 @@ static int gdb_flash_program = 1;
  */
 static int gdb_report_data_abort;
 
+/* if set, memory reads are served from a cache that's dropped
+ * whenever the target runs. Disabled by default. */
+static int gdb_mem_cache;
+static struct gdb_mem_cache_stats gdb_mem_cache_stats;
+
 /* set if we are sending target descriptions to gdb
  * via qXfer:features:read packet */
 /* enabled by default */
@@ -345,10 +395,55 @@ static int gdb_write(struct connection *connection, void *data, int len)
 	return ERROR_SERVER_REMOTE_CLOSED;
 }
 
+static int gdb_writev(struct connection *connection, struct iovec *iov, int iovcnt)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	int len = 0;
+
+	if (gdb_con->closed)
+		return ERROR_SERVER_REMOTE_CLOSED;
+
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+
+	if (connection_writev(connection, iov, iovcnt) == len)
+		return ERROR_OK;
+	gdb_con->closed = 1;
+	return ERROR_SERVER_REMOTE_CLOSED;
+}
+
+/* Sum of the bytes modulo 256. Eight bytes are added at a time, as four
+ * 16 bit lanes, which can take 128 words before they could overflow. */
+static unsigned char gdb_checksum(const char *buffer, int len)
+{
+	const uint64_t lane_mask = 0x00ff00ff00ff00ffULL;
+	unsigned char sum = 0;
+
+	while (len >= 8) {
+		uint64_t lanes = 0;
+		int words = MIN(len / 8, 128);
+
+		for (int i = 0; i < words; i++) {
+			uint64_t v;
+			memcpy(&v, buffer, 8);
+			lanes += (v & lane_mask) + ((v >> 8) & lane_mask);
+			buffer += 8;
+		}
+		len -= words * 8;
+
+		sum += (lanes & 0xffff) + ((lanes >> 16) & 0xffff)
+			+ ((lanes >> 32) & 0xffff) + (lanes >> 48);
+	}
+
+	while (len-- > 0)
+		sum += *buffer++;
+
+	return sum;
+}
+
 static int gdb_put_packet_inner(struct connection *connection,
 		char *buffer, int len)
 {
-	int i;
 	unsigned char my_checksum = 0;
 #ifdef _DEBUG_GDB_IO_
 	char *debug_buffer;
@@ -357,8 +452,7 @@ static int gdb_put_packet_inner(struct connection *connection,
 	int retval;
 	struct gdb_connection *gdb_con = connection->priv;
 
-	for (i = 0; i < len; i++)
-		my_checksum += buffer[i];
+	my_checksum = gdb_checksum(buffer, len);
 
 #ifdef _DEBUG_GDB_IO_
 	/*
@@ -405,15 +499,17 @@ static int gdb_put_packet_inner(struct connection *connection,
 				return retval;
 		} else {
 			/* larger packets are transmitted directly from caller supplied buffer
-			 * by several calls to gdb_write() to avoid dynamic allocation */
+			 * by a single gather write to avoid dynamic allocation */
+			struct iovec iov[3];
+
 			snprintf(local_buffer + 1, sizeof(local_buffer) - 1, "#%02x", my_checksum);
-			retval = gdb_write(connection, local_buffer, 1);
-			if (retval != ERROR_OK)
-				return retval;
-			retval = gdb_write(connection, buffer, len);
-			if (retval != ERROR_OK)
-				return retval;
-			retval = gdb_write(connection, local_buffer + 1, 3);
+			iov[0].iov_base = local_buffer;
+			iov[0].iov_len = 1;
+			iov[1].iov_base = buffer;
+			iov[1].iov_len = len;
+			iov[2].iov_base = local_buffer + 1;
+			iov[2].iov_len = 3;
+			retval = gdb_writev(connection, iov, 3);
 			if (retval != ERROR_OK)
 				return retval;
 		}
@@ -471,6 +567,11 @@ static int gdb_put_packet_inner(struct connection *connection,
 int gdb_put_packet(struct connection *connection, char *buffer, int len)
 {
 	struct gdb_connection *gdb_con = connection->priv;
+
+	/* log output must go out before replies, e.g. the stop reply */
+	if (gdb_con->log_len > 0 && !gdb_con->busy)
+		gdb_flush_log(connection);
+
 	gdb_con->busy = 1;
 	int retval = gdb_put_packet_inner(connection, buffer, len);
 	gdb_con->busy = 0;
@@ -705,6 +806,46 @@ static int gdb_output_con(struct connection *connection, const char *line)
 	return retval;
 }
 
+/* send the collected log output as one O packet */
+static int gdb_flush_log(struct connection *connection)
+{
+	struct gdb_connection *gdb_con = connection->priv;
+	int retval;
+
+	/* flushed before the timer fired, e.g. ahead of a reply */
+	if (gdb_con->log_flush_pending) {
+		gdb_con->log_flush_pending = false;
+		target_unregister_timer_callback(gdb_log_flush_callback, connection);
+	}
+
+	if (gdb_con->log_len == 0)
+		return ERROR_OK;
+
+	/* clear it first, gdb_put_packet() would flush it again */
+	gdb_con->log_len = 0;
+	retval = gdb_output_con(connection, gdb_con->log_buf);
+
+	return retval;
+}
+
+static int gdb_log_flush_callback(void *priv)
+{
+	struct connection *connection = priv;
+	struct gdb_connection *gdb_con = connection->priv;
+
+	/* this one-shot entry is removed by the timer code once we return */
+	gdb_con->log_flush_pending = false;
+
+	if (gdb_con->busy) {
+		/* try again on the next pass; the new entry goes after this one,
+		 * so removing this one can't match it */
+		gdb_con->log_flush_pending = true;
+		return target_register_timer_callback(gdb_log_flush_callback, 0, 0, connection);
+	}
+
+	return gdb_flush_log(connection);
+}
+
 static int gdb_output(struct command_context *context, const char *line)
 {
 	/* this will be dumped to the log and also sent as an O packet if possible */
@@ -885,6 +1026,36 @@ static void gdb_frontend_halted(struct target *target, struct connection *connec
 	}
 }
 
+/* Drop cached memory; lines in flash are kept unless flash is true. */
+static void gdb_mem_cache_invalidate(struct gdb_connection *gdb_connection, bool flash)
+{
+	if (gdb_connection->mem_cache == NULL)
+		return;
+
+	for (int i = 0; i < GDB_MEM_CACHE_LINES; i++) {
+		struct gdb_mem_cache_line *line = &gdb_connection->mem_cache[i];
+		if (line->valid && (flash || !line->flash)) {
+			line->valid = false;
+			gdb_mem_cache_stats.invalidations++;
+		}
+	}
+}
+
+/* Sum of the memory write counters of the target and, with SMP, of the
+ * targets sharing its memory. */
+static uint32_t gdb_mem_cache_serial(struct target *target)
+{
+	uint32_t serial = 0;
+
+	if (!target->smp)
+		return target->memory_write_count;
+
+	for (struct target_list *head = target->head; head; head = head->next)
+		serial += head->target->memory_write_count;
+
+	return serial;
+}
+
 static int gdb_target_callback_event_handler(struct target *target,
 		enum target_event event, void *priv)
 {
@@ -895,6 +1066,23 @@ static int gdb_target_callback_event_handler(struct target *target,
 	if (gdb_service->target != target)
 		return ERROR_OK;
 
+	switch (event) {
+		case TARGET_EVENT_RESUMED:
+		case TARGET_EVENT_HALTED:
+			/* the program may have changed RAM, but not flash */
+			gdb_mem_cache_invalidate(connection->priv, false);
+			break;
+		case TARGET_EVENT_DEBUG_RESUMED:	/* e.g. a flash algorithm */
+		case TARGET_EVENT_RESET_START:
+		case TARGET_EVENT_EXAMINE_END:
+		case TARGET_EVENT_GDB_FLASH_ERASE_END:
+		case TARGET_EVENT_GDB_FLASH_WRITE_END:
+			gdb_mem_cache_invalidate(connection->priv, true);
+			break;
+		default:
+			break;
+	}
+
 	switch (event) {
 		case TARGET_EVENT_GDB_HALT:
 			gdb_frontend_halted(target, connection);
@@ -929,6 +1117,16 @@ static int gdb_new_connection(struct connection *connection)
 	gdb_connection->ctrl_c = 0;
 	gdb_connection->frontend_state = TARGET_HALTED;
 	gdb_connection->vflash_image = NULL;
+	gdb_connection->vflash_buf = NULL;
+	gdb_connection->vflash_addr = 0;
+	gdb_connection->vflash_len = 0;
+	gdb_connection->vflash_started = false;
+	gdb_connection->vflash_retval = ERROR_OK;
+	gdb_connection->mem_cache = NULL;
+	gdb_connection->mem_cache_serial = 0;
+	gdb_connection->log_buf = NULL;
+	gdb_connection->log_len = 0;
+	gdb_connection->log_flush_pending = false;
 	gdb_connection->closed = 0;
 	gdb_connection->busy = 0;
 	gdb_connection->noack_mode = 0;
@@ -1014,6 +1212,11 @@ static int gdb_connection_closed(struct connection *connection)
 	 * cleaning up connection.
 	 */
 	log_remove_callback(gdb_log_callback, connection);
+	if (gdb_connection->log_flush_pending)
+		target_unregister_timer_callback(gdb_log_flush_callback, connection);
+	free(gdb_connection->log_buf);
+	gdb_connection->log_buf = NULL;
+	gdb_connection->log_len = 0;
 
 	gdb_actual_connections--;
 	LOG_DEBUG("GDB Close, Target: %s, state: %s, gdb_actual_connections=%d",
@@ -1027,6 +1230,10 @@ static int gdb_connection_closed(struct connection *connection)
 		free(gdb_connection->vflash_image);
 		gdb_connection->vflash_image = NULL;
 	}
+	free(gdb_connection->vflash_buf);
+	gdb_connection->vflash_buf = NULL;
+	free(gdb_connection->mem_cache);
+	gdb_connection->mem_cache = NULL;
 
 	/* if this connection registered a debug-message receiver delete it */
 	delete_debug_msg_receiver(connection->cmd_ctx, gdb_service->target);
@@ -1345,18 +1552,154 @@ static int gdb_error(struct connection *connection, int retval)
 	return ERROR_OK;
 }
 
+static bool gdb_mem_cache_hit(struct gdb_connection *gdb_connection,
+		target_addr_t address)
+{
+	struct gdb_mem_cache_line *line = &gdb_connection->mem_cache[
+		(address / GDB_MEM_CACHE_LINE_SIZE) % GDB_MEM_CACHE_LINES];
+
+	return line->valid && line->address == address;
+}
+
+/* Read target memory for GDB, through the cache if it's enabled. Runs of
+ * missing lines are fetched with a single target read. If a line can't be
+ * read as a whole, only the bytes GDB asked for are read, uncached. */
+static int gdb_read_memory(struct connection *connection,
+		target_addr_t address, uint32_t size, uint8_t *buffer)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+	struct target *target = get_target_from_connection(connection);
+	target_addr_t first, last, end;
+	uint8_t *fill;
+	int retval;
+
+	if (!gdb_mem_cache)
+		return target_read_buffer(target, address, size, buffer);
+
+	/* memory written by anyone, e.g. from telnet or another connection,
+	 * makes every line suspect */
+	uint32_t serial = gdb_mem_cache_serial(target);
+	if (serial != gdb_connection->mem_cache_serial) {
+		gdb_mem_cache_invalidate(gdb_connection, true);
+		gdb_connection->mem_cache_serial = serial;
+	}
+
+	first = address & ~(target_addr_t)(GDB_MEM_CACHE_LINE_SIZE - 1);
+	last = (address + size - 1) & ~(target_addr_t)(GDB_MEM_CACHE_LINE_SIZE - 1);
+	if (last < first || (last - first) / GDB_MEM_CACHE_LINE_SIZE >= GDB_MEM_CACHE_LINES) {
+		/* wraps around or wouldn't fit in the cache anyway */
+		gdb_mem_cache_stats.uncached++;
+		return target_read_buffer(target, address, size, buffer);
+	}
+
+	if (gdb_connection->mem_cache == NULL) {
+		gdb_connection->mem_cache = calloc(GDB_MEM_CACHE_LINES,
+				sizeof(struct gdb_mem_cache_line));
+		if (gdb_connection->mem_cache == NULL)
+			return target_read_buffer(target, address, size, buffer);
+	}
+
+	fill = malloc(last - first + GDB_MEM_CACHE_LINE_SIZE);
+	if (fill == NULL)
+		return target_read_buffer(target, address, size, buffer);
+
+	retval = ERROR_OK;
+	for (target_addr_t start = first; start <= last; start = end) {
+		end = start;
+		if (gdb_mem_cache_hit(gdb_connection, start)) {
+			gdb_mem_cache_stats.hits++;
+			end = start + GDB_MEM_CACHE_LINE_SIZE;
+		} else {
+			while (end <= last && !gdb_mem_cache_hit(gdb_connection, end)) {
+				gdb_mem_cache_stats.misses++;
+				end += GDB_MEM_CACHE_LINE_SIZE;
+			}
+
+			retval = target_read_buffer(target, start, end - start,
+					fill + (start - first));
+			if (retval != ERROR_OK) {
+				/* maybe just the prefetched bytes were out of reach */
+				target_addr_t from = MAX(start, address);
+				target_addr_t to = MIN(end, address + size);
+
+				gdb_mem_cache_stats.uncached++;
+				retval = target_read_buffer(target, from, to - from,
+						buffer + (from - address));
+				if (retval != ERROR_OK)
+					break;
+				continue;
+			}
+
+			for (target_addr_t a = start; a < end; a += GDB_MEM_CACHE_LINE_SIZE) {
+				struct gdb_mem_cache_line *line = &gdb_connection->mem_cache[
+					(a / GDB_MEM_CACHE_LINE_SIZE) % GDB_MEM_CACHE_LINES];
+				struct flash_bank *bank;
+
+				line->valid = true;
+				line->address = a;
+				line->flash = get_flash_bank_by_addr(target, a, false, &bank) == ERROR_OK
+					&& bank != NULL;
+				memcpy(line->data, fill + (a - first), GDB_MEM_CACHE_LINE_SIZE);
+			}
+		}
+
+		/* copy the requested part of the lines we now have */
+		for (target_addr_t a = start; a < end; a += GDB_MEM_CACHE_LINE_SIZE) {
+			struct gdb_mem_cache_line *line = &gdb_connection->mem_cache[
+				(a / GDB_MEM_CACHE_LINE_SIZE) % GDB_MEM_CACHE_LINES];
+			target_addr_t from = MAX(a, address);
+			target_addr_t to = MIN(a + GDB_MEM_CACHE_LINE_SIZE, address + size);
+
+			memcpy(buffer + (from - address), line->data + (from - a), to - from);
+		}
+	}
+
+	free(fill);
+	return retval;
+}
+
+/* Encode memory for an 'x' reply: 'b' followed by the bytes, with the
+ * characters that are special in packets escaped as '}' and the byte
+ * xor 0x20. The reply may be shorter than requested, so stop when the
+ * packet would no longer fit. Returns the packet length. */
+static size_t gdb_encode_binary(char *out, size_t out_size,
+		const uint8_t *buffer, uint32_t len)
+{
+	size_t pos = 0;
+
+	out[pos++] = 'b';
+	for (uint32_t i = 0; i < len; i++) {
+		uint8_t c = buffer[i];
+
+		if (c == '#' || c == '$' || c == '}' || c == '*') {
+			if (pos + 2 > out_size)
+				break;
+			out[pos++] = '}';
+			out[pos++] = c ^ 0x20;
+		} else {
+			if (pos + 1 > out_size)
+				break;
+			out[pos++] = c;
+		}
+	}
+
+	return pos;
+}
+
 /* We don't have to worry about the default 2 second timeout for GDB packets,
  * because GDB breaks up large memory reads into smaller reads.
  *
  * 8191 bytes by the looks of it. Why 8191 bytes instead of 8192?????
+ *
+ * Handles both 'm' (hex) and 'x' (binary) memory reads.
  */
 static int gdb_read_memory_packet(struct connection *connection,
 		char const *packet, int packet_size)
 {
-	struct target *target = get_target_from_connection(connection);
 	char *separator;
 	uint64_t addr = 0;
 	uint32_t len = 0;
+	bool binary = packet[0] == 'x';
 
 	uint8_t *buffer;
 	char *hex_buffer;
@@ -1375,6 +1718,12 @@ static int gdb_read_memory_packet(struct connection *connection,
 
 	len = strtoul(separator + 1, NULL, 16);
 
+	if (!len && binary) {
+		/* GDB never asks for this, but it's a valid empty read */
+		gdb_put_packet(connection, "b", 1);
+		return ERROR_OK;
+	}
+
 	if (!len) {
 		LOG_WARNING("invalid read memory packet received (len == 0)");
 		gdb_put_packet(connection, NULL, 0);
@@ -1385,7 +1734,7 @@ static int gdb_read_memory_packet(struct connection *connection,
 
 	LOG_DEBUG("addr: 0x%16.16" PRIx64 ", len: 0x%8.8" PRIx32 "", addr, len);
 
-	retval = target_read_buffer(target, addr, len, buffer);
+	retval = gdb_read_memory(connection, addr, len, buffer);
 
 	if ((retval != ERROR_OK) && !gdb_report_data_abort) {
 		/* TODO : Here we have to lie and send back all zero's lest stack traces won't work.
@@ -1405,7 +1754,16 @@ static int gdb_read_memory_packet(struct connection *connection,
 		retval = ERROR_OK;
 	}
 
-	if (retval == ERROR_OK) {
+	if (retval == ERROR_OK && binary) {
+		size_t out_size = MIN((size_t)len * 2 + 1, GDB_BUFFER_SIZE - 1);
+		char *bin_buffer = malloc(out_size);
+
+		size_t pkt_len = gdb_encode_binary(bin_buffer, out_size, buffer, len);
+
+		gdb_put_packet(connection, bin_buffer, pkt_len);
+
+		free(bin_buffer);
+	} else if (retval == ERROR_OK) {
 		hex_buffer = malloc(len * 2 + 1);
 
 		size_t pkt_len = hexify(hex_buffer, buffer, len, len * 2 + 1);
@@ -1557,6 +1915,8 @@ static int gdb_step_continue_packet(struct connection *connection,
 	else
 		current = 1;
 
+	gdb_mem_cache_invalidate(connection->priv, false);
+
 	gdb_running_type = packet[0];
 	if (packet[0] == 'c') {
 		LOG_DEBUG("continue");
@@ -2340,12 +2700,23 @@ static int gdb_generate_thread_list(struct target *target, char **thread_list_ou
 static int gdb_get_thread_list_chunk(struct target *target, char **thread_list,
 		char **chunk, int32_t offset, uint32_t length)
 {
+	struct rtos *rtos = target->rtos;
+
+	if (*thread_list == NULL && rtos != NULL && rtos->thread_list_xml != NULL) {
+		/* the thread list hasn't changed since the document was built */
+		*thread_list = strdup(rtos->thread_list_xml);
+	}
+
 	if (*thread_list == NULL) {
 		int retval = gdb_generate_thread_list(target, thread_list);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("Unable to Generate Thread List");
 			return ERROR_FAIL;
 		}
+		if (rtos != NULL) {
+			free(rtos->thread_list_xml);
+			rtos->thread_list_xml = strdup(*thread_list);
+		}
 	}
 
 	size_t thread_list_length = strlen(*thread_list);
@@ -2386,6 +2757,9 @@ static int gdb_query_packet(struct connection *connection,
 	if (strncmp(packet, "qRcmd,", 6) == 0) {
 		if (packet_size > 6) {
 			char *cmd;
+			/* monitor commands may write memory or flash */
+			gdb_mem_cache_invalidate(connection->priv, true);
+
 			cmd = malloc((packet_size - 6) / 2 + 1);
 			size_t len = unhexify((uint8_t *)cmd, packet + 6, (packet_size - 6) / 2);
 			cmd[len] = 0;
@@ -2465,7 +2839,7 @@ static int gdb_query_packet(struct connection *connection,
 			&buffer,
 			&pos,
 			&size,
-			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;qXfer:threads:read+;QStartNoAckMode+",
+			"PacketSize=%x;qXfer:memory-map:read%c;qXfer:features:read%c;qXfer:threads:read+;QStartNoAckMode+;binary-upload+",
 			(GDB_BUFFER_SIZE - 1),
 			((gdb_use_memory_map == 1) && (flash_get_bank_count() > 0)) ? '+' : '-',
 			(gdb_target_desc_supported == 1) ? '+' : '-');
@@ -2554,6 +2928,121 @@ static int gdb_query_packet(struct connection *connection,
 	return ERROR_OK;
 }
 
+/* Find the flash sector holding addr, returns false if there is none. */
+static bool gdb_vflash_sector(struct target *target, uint32_t addr,
+		uint32_t *start, uint32_t *end, uint8_t *padded_value)
+{
+	struct flash_bank *bank;
+
+	if (get_flash_bank_by_addr(target, addr, false, &bank) != ERROR_OK || bank == NULL)
+		return false;
+
+	for (int i = 0; i < bank->num_sectors; i++) {
+		uint32_t sector_start = bank->base + bank->sectors[i].offset;
+		uint32_t sector_end = sector_start + bank->sectors[i].size;
+
+		if (addr >= sector_start && addr < sector_end) {
+			*start = sector_start;
+			*end = sector_end;
+			*padded_value = bank->default_padded_value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Program the first length bytes of the streaming vFlash buffer. */
+static void gdb_vflash_program(struct connection *connection, uint32_t length)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+	struct gdb_service *gdb_service = connection->service->priv;
+
+	/* once something failed, only drain the buffer until vFlashDone */
+	if (gdb_connection->vflash_retval == ERROR_OK) {
+		struct image image;
+		uint32_t written;
+		int retval;
+
+		if (!gdb_connection->vflash_started) {
+			target_call_event_callbacks(gdb_service->target,
+					TARGET_EVENT_GDB_FLASH_WRITE_START);
+			gdb_connection->vflash_started = true;
+		}
+
+		retval = image_open(&image, "", "build");
+		if (retval == ERROR_OK) {
+			retval = image_add_section(&image, gdb_connection->vflash_addr,
+					length, 0x0, gdb_connection->vflash_buf);
+			if (retval == ERROR_OK)
+				retval = flash_write(gdb_service->target, &image, &written, 0);
+			image_close(&image);
+		}
+
+		if (retval != ERROR_OK) {
+			LOG_ERROR("streaming vFlash write at 0x%08" PRIx32 " failed",
+					gdb_connection->vflash_addr);
+			gdb_connection->vflash_retval = retval;
+		} else
+			LOG_DEBUG("wrote %u bytes from vFlash stream to flash", (unsigned)written);
+	}
+
+	memmove(gdb_connection->vflash_buf, gdb_connection->vflash_buf + length,
+			gdb_connection->vflash_len - length);
+	gdb_connection->vflash_addr += length;
+	gdb_connection->vflash_len -= length;
+}
+
+/* Add a vFlashWrite chunk to the stream and program all sectors it completes. */
+static void gdb_vflash_stream(struct connection *connection, uint32_t addr,
+		uint32_t length, const uint8_t *data)
+{
+	struct gdb_connection *gdb_connection = connection->priv;
+	struct target *target = get_target_from_connection(connection);
+	uint32_t end = gdb_connection->vflash_addr + gdb_connection->vflash_len;
+	uint32_t sector_start, sector_end;
+	uint8_t padded_value;
+
+	if (gdb_connection->vflash_len > 0 && addr != end) {
+		/* a hole inside the last sector is padded, anything else
+		 * starts a new run */
+		if (addr > end && gdb_vflash_sector(target, end - 1,
+					&sector_start, &sector_end, &padded_value) && addr < sector_end) {
+			uint8_t *buf = realloc(gdb_connection->vflash_buf,
+					gdb_connection->vflash_len + (addr - end));
+			if (buf == NULL) {
+				gdb_connection->vflash_retval = ERROR_FAIL;
+				return;
+			}
+			memset(buf + gdb_connection->vflash_len, padded_value, addr - end);
+			gdb_connection->vflash_buf = buf;
+			gdb_connection->vflash_len += addr - end;
+		} else
+			gdb_vflash_program(connection, gdb_connection->vflash_len);
+	}
+
+	if (gdb_connection->vflash_len == 0)
+		gdb_connection->vflash_addr = addr;
+
+	uint8_t *buf = realloc(gdb_connection->vflash_buf, gdb_connection->vflash_len + length);
+	if (buf == NULL) {
+		gdb_connection->vflash_retval = ERROR_FAIL;
+		return;
+	}
+	memcpy(buf + gdb_connection->vflash_len, data, length);
+	gdb_connection->vflash_buf = buf;
+	gdb_connection->vflash_len += length;
+
+	/* program up to the start of the last, still incomplete, sector */
+	end = gdb_connection->vflash_addr + gdb_connection->vflash_len;
+	if (!gdb_vflash_sector(target, end - 1, &sector_start, &sector_end, &padded_value))
+		return;
+	if (sector_end == end)
+		sector_start = end;
+	if (sector_start > gdb_connection->vflash_addr)
+		gdb_vflash_program(connection, sector_start - gdb_connection->vflash_addr);
+}
+
 static int gdb_v_packet(struct connection *connection,
 		char const *packet, int packet_size)
 {
@@ -2592,6 +3081,10 @@ static int gdb_v_packet(struct connection *connection,
 			return ERROR_SERVER_REMOTE_CLOSED;
 		}
 
+		/* programming streamed data must not be reordered with erases */
+		if (gdb_connection->vflash_len > 0)
+			gdb_vflash_program(connection, gdb_connection->vflash_len);
+
 		/* assume all sectors need erasing - stops any problems
 		 * when flash_write is called multiple times */
 		flash_set_dirty();
@@ -2641,6 +3134,14 @@ static int gdb_v_packet(struct connection *connection,
 		}
 		length = packet_size - (parse - packet);
 
+		if (gdb_flash_streaming) {
+			/* reply first, so that GDB prepares and sends the next
+			 * packet while the target is programming this one */
+			gdb_put_packet(connection, "OK", 2);
+			gdb_vflash_stream(connection, addr, length, (uint8_t const *)parse);
+			return ERROR_OK;
+		}
+
 		/* create a new image if there isn't already one */
 		if (gdb_connection->vflash_image == NULL) {
 			gdb_connection->vflash_image = malloc(sizeof(struct image));
@@ -2658,6 +3159,31 @@ static int gdb_v_packet(struct connection *connection,
 		return ERROR_OK;
 	}
 
+	if (strncmp(packet, "vFlashDone", 10) == 0 && gdb_flash_streaming) {
+		if (gdb_connection->vflash_len > 0)
+			gdb_vflash_program(connection, gdb_connection->vflash_len);
+		if (!gdb_connection->vflash_started)
+			target_call_event_callbacks(gdb_service->target,
+					TARGET_EVENT_GDB_FLASH_WRITE_START);
+		target_call_event_callbacks(gdb_service->target, TARGET_EVENT_GDB_FLASH_WRITE_END);
+
+		result = gdb_connection->vflash_retval;
+		if (result == ERROR_FLASH_DST_OUT_OF_BANK)
+			gdb_put_packet(connection, "E.memtype", 9);
+		else if (result != ERROR_OK)
+			gdb_send_error(connection, EIO);
+		else
+			gdb_put_packet(connection, "OK", 2);
+
+		free(gdb_connection->vflash_buf);
+		gdb_connection->vflash_buf = NULL;
+		gdb_connection->vflash_len = 0;
+		gdb_connection->vflash_started = false;
+		gdb_connection->vflash_retval = ERROR_OK;
+
+		return ERROR_OK;
+	}
+
 	if (strncmp(packet, "vFlashDone", 10) == 0) {
 		uint32_t written;
 
@@ -2750,13 +3276,40 @@ static void gdb_log_callback(void *priv, const char *file, unsigned line,
 {
 	struct connection *connection = priv;
 	struct gdb_connection *gdb_con = connection->priv;
+	int len = strlen(string);
 
 	if (gdb_con->busy) {
 		/* do not reply this using the O packet */
 		return;
 	}
 
-	gdb_output_con(connection, string);
+	/* collect the output, it's sent as one O packet from a timer callback
+	 * once the event loop is done with this pass, or before the next reply */
+	if (gdb_con->log_len + len > GDB_LOG_BUFFER_SIZE)
+		gdb_flush_log(connection);
+
+	if (len > GDB_LOG_BUFFER_SIZE) {
+		gdb_output_con(connection, string);
+		return;
+	}
+
+	if (gdb_con->log_buf == NULL) {
+		gdb_con->log_buf = malloc(GDB_LOG_BUFFER_SIZE + 1);
+		if (gdb_con->log_buf == NULL) {
+			gdb_output_con(connection, string);
+			return;
+		}
+	}
+
+	memcpy(gdb_con->log_buf + gdb_con->log_len, string, len);
+	gdb_con->log_len += len;
+	gdb_con->log_buf[gdb_con->log_len] = 0;
+
+	/* one flush per event loop pass, armed by the first line of output */
+	if (!gdb_con->log_flush_pending) {
+		gdb_con->log_flush_pending = true;
+		target_register_timer_callback(gdb_log_flush_callback, 0, 0, connection);
+	}
 }
 
 static void gdb_sig_halted(struct connection *connection)
@@ -2841,6 +3394,7 @@ static int gdb_input_inner(struct connection *connection)
 					retval = gdb_set_register_packet(connection, packet, packet_size);
 					break;
 				case 'm':
+				case 'x':
 					retval = gdb_read_memory_packet(connection, packet, packet_size);
 					break;
 				case 'M':
@@ -3156,6 +3710,15 @@ COMMAND_HANDLER(handle_gdb_flash_program_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_gdb_flash_streaming_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_ENABLE(CMD_ARGV[0], gdb_flash_streaming);
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_gdb_report_data_abort_command)
 {
 	if (CMD_ARGC != 1)
@@ -3165,6 +3728,40 @@ COMMAND_HANDLER(handle_gdb_report_data_abort_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_gdb_mem_cache_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_ENABLE(CMD_ARGV[0], gdb_mem_cache);
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_gdb_mem_cache_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		memset(&gdb_mem_cache_stats, 0, sizeof(gdb_mem_cache_stats));
+		return ERROR_OK;
+	}
+
+	uint64_t lookups = gdb_mem_cache_stats.hits + gdb_mem_cache_stats.misses;
+
+	command_print(CMD_CTX, "gdb memory cache %s, line size %d, %d lines",
+			gdb_mem_cache ? "enabled" : "disabled",
+			GDB_MEM_CACHE_LINE_SIZE, GDB_MEM_CACHE_LINES);
+	command_print(CMD_CTX, "hits %" PRIu64 ", misses %" PRIu64 " (%u%% hit rate)",
+			gdb_mem_cache_stats.hits, gdb_mem_cache_stats.misses,
+			lookups ? (unsigned)(gdb_mem_cache_stats.hits * 100 / lookups) : 0);
+	command_print(CMD_CTX, "uncached reads %" PRIu64 ", lines invalidated %" PRIu64,
+			gdb_mem_cache_stats.uncached, gdb_mem_cache_stats.invalidations);
+	return ERROR_OK;
+}
+
 /* gdb_breakpoint_override */
 COMMAND_HANDLER(handle_gdb_breakpoint_override_command)
 {
@@ -3279,6 +3876,14 @@ static const struct command_registration gdb_command_handlers[] = {
 		.help = "enable or disable flash program",
 		.usage = "('enable'|'disable')"
 	},
+	{
+		.name = "gdb_flash_streaming",
+		.handler = handle_gdb_flash_streaming_command,
+		.mode = COMMAND_CONFIG,
+		.help = "enable or disable programming flash sectors while "
+			"GDB is still sending the image",
+		.usage = "('enable'|'disable')"
+	},
 	{
 		.name = "gdb_report_data_abort",
 		.handler = handle_gdb_report_data_abort_command,
@@ -3286,6 +3891,21 @@ static const struct command_registration gdb_command_handlers[] = {
 		.help = "enable or disable reporting data aborts",
 		.usage = "('enable'|'disable')"
 	},
+	{
+		.name = "gdb_mem_cache",
+		.handler = handle_gdb_mem_cache_command,
+		.mode = COMMAND_ANY,
+		.help = "enable or disable caching memory read by GDB "
+			"while the target is halted",
+		.usage = "('enable'|'disable')"
+	},
+	{
+		.name = "gdb_mem_cache_stats",
+		.handler = handle_gdb_mem_cache_stats_command,
+		.mode = COMMAND_ANY,
+		.help = "show or reset the GDB memory cache hit/miss counters",
+		.usage = "['reset']"
+	},
 	{
 		.name = "gdb_breakpoint_override",
 		.handler = handle_gdb_breakpoint_override_command,
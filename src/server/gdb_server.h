@@ -32,7 +32,7 @@ struct image;
 struct reg;
 #include <target/target.h>
 
-#define GDB_BUFFER_SIZE 16384
+#define GDB_BUFFER_SIZE 32768
 
 int gdb_target_add_all(struct target *target);
 int gdb_register_commands(struct command_context *command_context);
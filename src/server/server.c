@@ -44,6 +44,10 @@
 #include <netinet/tcp.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 static struct service *services;
 
 /* shutdown_openocd == 1: exit the main event loop, and quit the
@@ -59,6 +63,62 @@ static int polling_period = 100;
 /* address by name on which to listen for incoming TCP/IP connections */
 static char *bindto_name;
 
+#ifdef HAVE_SYS_EPOLL_H
+#define EPOLL_MAX_EVENTS 32
+
+/* epoll instance of server_loop(), -1 until the loop starts. Listeners
+ * and connections are registered once, when they come and go. */
+static int epoll_fd = -1;
+
+/* events returned by the last epoll_wait() that are still being handled */
+static struct epoll_event epoll_events[EPOLL_MAX_EVENTS];
+static int epoll_event_count;
+
+/* set when an fd can't be watched with epoll, e.g. stdin redirected from
+ * a regular file or /dev/null; server_loop() then goes on with select() */
+static bool epoll_unsupported;
+#endif
+
+/* start watching fd for input; ptr is the service or connection owning it */
+static void server_watch_fd(int fd, void *ptr)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event ev;
+
+	if (epoll_fd == -1 || fd == -1)
+		return;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = ptr;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1 && errno != EEXIST) {
+		/* select() reports such fds as always readable, let it handle them */
+		LOG_DEBUG("couldn't watch fd %d with epoll: %s", fd, strerror(errno));
+		epoll_unsupported = true;
+	}
+#endif
+}
+
+static void server_unwatch_fd(int fd, void *ptr)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event ev;
+
+	if (epoll_fd == -1 || fd == -1)
+		return;
+
+	/* pre 2.6.9 kernels want a non-NULL event even here */
+	memset(&ev, 0, sizeof(ev));
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+
+	/* ptr may be about to be freed, forget pending events for it */
+	for (int i = 0; i < epoll_event_count; i++) {
+		if (epoll_events[i].data.ptr == ptr)
+			epoll_events[i].data.ptr = NULL;
+	}
+#endif
+}
+
 static int add_connection(struct service *service, struct command_context *cmd_ctx)
 {
 	socklen_t address_size;
@@ -105,6 +165,7 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 	} else if (service->type == CONNECTION_STDINOUT) {
 		c->fd = service->fd;
 		c->fd_out = fileno(stdout);
+		server_unwatch_fd(service->fd, service);
 
 #ifdef _WIN32
 		/* we are using stdin/out so ignore ctrl-c under windoze */
@@ -124,6 +185,7 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 		}
 	} else if (service->type == CONNECTION_PIPE) {
 		c->fd = service->fd;
+		server_unwatch_fd(service->fd, service);
 		/* do not check for new connections again on stdin */
 		service->fd = -1;
 
@@ -150,6 +212,8 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 		;
 	*p = c;
 
+	server_watch_fd(c->fd, c);
+
 	if (service->max_connections != CONNECTION_LIMIT_UNLIMITED)
 		service->max_connections--;
 
@@ -165,11 +229,13 @@ static int remove_connection(struct service *service, struct connection *connect
 	while ((c = *p)) {
 		if (c->fd == connection->fd) {
 			service->connection_closed(c);
+			server_unwatch_fd(c->fd, c);
 			if (service->type == CONNECTION_TCP)
 				close_socket(c->fd);
 			else if (service->type == CONNECTION_PIPE) {
 				/* The service will listen to the pipe again */
 				c->service->fd = c->fd;
+				server_watch_fd(c->service->fd, c->service);
 			}
 
 			command_done(c->cmd_ctx);
@@ -318,6 +384,9 @@ int add_service(char *name,
 		;
 	*p = c;
 
+	/* services created by a later "init" aren't seen by the loop start */
+	server_watch_fd(c->fd, c);
+
 	return ERROR_OK;
 }
 
@@ -329,6 +398,8 @@ static int remove_services(void)
 	while (c) {
 		struct service *next = c->next;
 
+		server_unwatch_fd(c->fd, c);
+
 		if (c->name)
 			free(c->name);
 
@@ -354,6 +425,143 @@ static int remove_services(void)
 	return ERROR_OK;
 }
 
+/* accept, or reject, a new connection on a listener */
+static void service_accept(struct service *service, struct command_context *cmd_ctx)
+{
+	if (service->max_connections != 0)
+		add_connection(service, cmd_ctx);
+	else {
+		if (service->type == CONNECTION_TCP) {
+			struct sockaddr_in sin;
+			socklen_t address_size = sizeof(sin);
+			int tmp_fd;
+			tmp_fd = accept(service->fd,
+					(struct sockaddr *)&service->sin,
+					&address_size);
+			close_socket(tmp_fd);
+		}
+		LOG_INFO(
+			"rejected '%s' connection, no more connections allowed",
+			service->name);
+	}
+}
+
+/* let the service handle input on a connection, the connection is
+ * dropped (and freed) if that fails */
+static void connection_input(struct service *service, struct connection *c)
+{
+	int retval = service->input(c);
+	if (retval != ERROR_OK) {
+		if (service->type == CONNECTION_PIPE ||
+				service->type == CONNECTION_STDINOUT) {
+			/* if connection uses a pipe then
+			 * shutdown openocd on error */
+			shutdown_openocd = 1;
+		}
+		remove_connection(service, c);
+		LOG_INFO("dropped '%s' connection",
+			service->name);
+	}
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/* Event loop for hosts with epoll. Unlike the select() loop it doesn't
+ * rebuild the fd set every time around, and rather than alternating
+ * between polling and fixed sleeps it sleeps until there's input or the
+ * next timer callback is due. */
+static int server_loop_epoll(struct command_context *command_context)
+{
+	struct service *service;
+	bool busy = true;
+
+	for (service = services; service; service = service->next) {
+		server_watch_fd(service->fd, service);
+		for (struct connection *c = service->connections; c; c = c->next)
+			server_watch_fd(c->fd, c);
+	}
+
+	while (!shutdown_openocd && !epoll_unsupported) {
+		int timeout = 0;
+
+		/* keep going without sleeping while there's work, this
+		 * greatly improves performance of DCC */
+		if (!busy && !target_got_message()) {
+			timeout = target_timer_next_event();
+			/* Jim's event loop needs servicing too, every 100ms by
+			 * default, can be changed with "poll_period" command */
+			if (timeout < 0 || timeout > polling_period)
+				timeout = polling_period;
+		}
+
+		int count;
+		if (timeout > 0) {
+			/* Only while we're sleeping we'll let others run */
+			openocd_sleep_prelude();
+			kept_alive();
+			count = epoll_wait(epoll_fd, epoll_events, EPOLL_MAX_EVENTS, timeout);
+			openocd_sleep_postlude();
+		} else
+			count = epoll_wait(epoll_fd, epoll_events, EPOLL_MAX_EVENTS, 0);
+
+		if (count == -1) {
+			if (errno != EINTR) {
+				LOG_ERROR("error during epoll_wait: %s", strerror(errno));
+				exit(-1);
+			}
+			count = 0;
+		}
+
+		epoll_event_count = count;
+		for (int i = 0; i < count; i++) {
+			void *ptr = epoll_events[i].data.ptr;
+
+			/* dropped while handling an earlier event */
+			if (ptr == NULL)
+				continue;
+
+			for (service = services; service; service = service->next) {
+				if (ptr == service)
+					break;
+			}
+
+			if (service)
+				service_accept(service, command_context);
+			else {
+				struct connection *c = ptr;
+				connection_input(c->service, c);
+			}
+		}
+		epoll_event_count = 0;
+
+		/* input already buffered by a service doesn't show up in epoll */
+		busy = count > 0;
+		for (service = services; service; service = service->next) {
+			struct connection *c = service->connections;
+
+			while (c) {
+				struct connection *next = c->next;
+
+				if (c->input_pending) {
+					connection_input(service, c);
+					busy = true;
+				}
+				c = next;
+			}
+		}
+
+		if (count == 0 || target_timer_next_event() == 0) {
+			target_call_timer_callbacks();
+			process_jim_events(command_context);
+		}
+	}
+
+	close(epoll_fd);
+	epoll_fd = -1;
+
+	return shutdown_openocd != 2 ? ERROR_OK : ERROR_FAIL;
+}
+#endif
+
 int server_loop(struct command_context *command_context)
 {
 	struct service *service;
@@ -372,6 +580,17 @@ int server_loop(struct command_context *command_context)
 		LOG_ERROR("couldn't set SIGPIPE to SIG_IGN");
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+	epoll_fd = epoll_create(EPOLL_MAX_EVENTS);
+	if (epoll_fd != -1) {
+		retval = server_loop_epoll(command_context);
+		if (!epoll_unsupported)
+			return retval;
+		LOG_INFO("input can't be watched with epoll, using select()");
+	} else
+		LOG_WARNING("couldn't create epoll instance: %s, using select()", strerror(errno));
+#endif
+
 	while (!shutdown_openocd) {
 		/* monitor sockets for activity */
 		fd_max = 0;
@@ -464,48 +683,18 @@ int server_loop(struct command_context *command_context)
 		for (service = services; service; service = service->next) {
 			/* handle new connections on listeners */
 			if ((service->fd != -1)
-			    && (FD_ISSET(service->fd, &read_fds))) {
-				if (service->max_connections != 0)
-					add_connection(service, command_context);
-				else {
-					if (service->type == CONNECTION_TCP) {
-						struct sockaddr_in sin;
-						socklen_t address_size = sizeof(sin);
-						int tmp_fd;
-						tmp_fd = accept(service->fd,
-								(struct sockaddr *)&service->sin,
-								&address_size);
-						close_socket(tmp_fd);
-					}
-					LOG_INFO(
-						"rejected '%s' connection, no more connections allowed",
-						service->name);
-				}
-			}
+			    && (FD_ISSET(service->fd, &read_fds)))
+				service_accept(service, command_context);
 
 			/* handle activity on connections */
 			if (service->connections) {
 				struct connection *c;
 
 				for (c = service->connections; c; ) {
-					if ((FD_ISSET(c->fd, &read_fds)) || c->input_pending) {
-						retval = service->input(c);
-						if (retval != ERROR_OK) {
-							struct connection *next = c->next;
-							if (service->type == CONNECTION_PIPE ||
-									service->type == CONNECTION_STDINOUT) {
-								/* if connection uses a pipe then
-								 * shutdown openocd on error */
-								shutdown_openocd = 1;
-							}
-							remove_connection(service, c);
-							LOG_INFO("dropped '%s' connection",
-								service->name);
-							c = next;
-							continue;
-						}
-					}
-					c = c->next;
+					struct connection *next = c->next;
+					if ((FD_ISSET(c->fd, &read_fds)) || c->input_pending)
+						connection_input(service, c);
+					c = next;
 				}
 			}
 		}
@@ -613,6 +802,42 @@ int connection_write(struct connection *connection, const void *data, int len)
 		return write(connection->fd_out, data, len);
 }
 
+int connection_writev(struct connection *connection, struct iovec *iov, int iovcnt)
+{
+	int total = 0;
+
+#ifdef HAVE_SYS_UIO_H
+	while (iovcnt > 0) {
+		ssize_t n = writev(connection->fd_out, iov, iovcnt);
+		if (n <= 0)
+			return total > 0 ? total : n;
+		total += n;
+
+		/* writev() may stop short, skip what went out */
+		while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+#else
+	for (int i = 0; i < iovcnt; i++) {
+		int n = connection_write(connection, iov[i].iov_base, iov[i].iov_len);
+		if (n < 0)
+			return total > 0 ? total : n;
+		total += n;
+		if ((size_t)n != iov[i].iov_len)
+			break;
+	}
+#endif
+
+	return total;
+}
+
 int connection_read(struct connection *connection, void *data, int len)
 {
 	if (connection->service->type == CONNECTION_TCP)
@@ -31,6 +31,15 @@
 #include <netinet/in.h>
 #endif
 
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#else
+struct iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+#endif
+
 enum connection_type {
 	CONNECTION_TCP,
 	CONNECTION_PIPE,
@@ -86,6 +95,12 @@ int server_register_commands(struct command_context *context);
 
 int connection_write(struct connection *connection, const void *data, int len);
 int connection_read(struct connection *connection, void *data, int len);
+/**
+ * Writes the buffers described by iov with as few system calls as the
+ * host allows; iov is updated as data goes out. Returns the number of
+ * bytes written, like connection_write().
+ */
+int connection_writev(struct connection *connection, struct iovec *iov, int iovcnt);
 
 /**
  * Used by server_loop(), defined in server_stubs.c
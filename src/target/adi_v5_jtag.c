@@ -352,7 +352,7 @@ static int adi_jtag_scan_inout_check_u32(struct adiv5_dap *dap,
 	return jtag_execute_queue();
 }
 
-static int jtagdp_overrun_check(struct adiv5_dap *dap)
+static int jtagdp_overrun_check(struct adiv5_dap *dap, bool *stalled)
 {
 	int retval;
 	struct dap_cmd *el, *tmp, *prev = NULL;
@@ -360,6 +360,9 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 	int64_t time_now;
 	LIST_HEAD(replay_list);
 
+	if (stalled != NULL)
+		*stalled = true;
+
 	/* make sure all queued transactions are complete */
 	retval = jtag_execute_queue();
 	if (retval != ERROR_OK)
@@ -481,6 +484,9 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 	/* we're done with the journal, flush it */
 	flush_journal(&dap->cmd_journal);
 
+	if (stalled != NULL)
+		*stalled = found_wait;
+
 	/* check for overrun condition in the last batch of transactions */
 	if (found_wait) {
 		LOG_INFO("DAP transaction stalled (WAIT) - slowing down");
@@ -550,20 +556,9 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 	return retval;
 }
 
-static int jtagdp_transaction_endcheck(struct adiv5_dap *dap)
+static int jtagdp_check_ctrlstat(struct adiv5_dap *dap, uint32_t ctrlstat)
 {
-	int retval;
-	uint32_t ctrlstat;
-
-	/* too expensive to call keep_alive() here */
-
-	/* Post CTRL/STAT read; discard any previous posted read value
-	 * but collect its ACK status.
-	 */
-	retval = adi_jtag_scan_inout_check_u32(dap, JTAG_DP_DPACC,
-			DP_CTRL_STAT, DPAP_READ, 0, &ctrlstat, 0);
-	if (retval != ERROR_OK)
-		goto done;
+	int retval = ERROR_OK;
 
 	/* REVISIT also STICKYCMP, for pushed comparisons (nyet used) */
 
@@ -585,17 +580,34 @@ static int jtagdp_transaction_endcheck(struct adiv5_dap *dap)
 		retval = adi_jtag_scan_inout_check_u32(dap, JTAG_DP_DPACC,
 				DP_CTRL_STAT, DPAP_WRITE,
 				dap->dp_ctrl_stat | SSTICKYERR, NULL, 0);
-		if (retval != ERROR_OK)
-			goto done;
-
-		retval = ERROR_JTAG_DEVICE_ERROR;
+		if (retval == ERROR_OK)
+			retval = ERROR_JTAG_DEVICE_ERROR;
 	}
 
- done:
 	flush_journal(&dap->cmd_journal);
 	return retval;
 }
 
+static int jtagdp_transaction_endcheck(struct adiv5_dap *dap)
+{
+	int retval;
+	uint32_t ctrlstat;
+
+	/* too expensive to call keep_alive() here */
+
+	/* Post CTRL/STAT read; discard any previous posted read value
+	 * but collect its ACK status.
+	 */
+	retval = adi_jtag_scan_inout_check_u32(dap, JTAG_DP_DPACC,
+			DP_CTRL_STAT, DPAP_READ, 0, &ctrlstat, 0);
+	if (retval != ERROR_OK) {
+		flush_journal(&dap->cmd_journal);
+		return retval;
+	}
+
+	return jtagdp_check_ctrlstat(dap, ctrlstat);
+}
+
 /*--------------------------------------------------------------------------*/
 
 static int jtag_dp_q_read(struct adiv5_dap *dap, unsigned reg,
@@ -673,10 +685,36 @@ static int jtag_dp_run(struct adiv5_dap *dap)
 	int retval;
 	int retval2 = ERROR_OK;
 
+	dap->run_count++;
+
 	retval = adi_jtag_finish_read(dap);
 	if (retval != ERROR_OK)
 		goto done;
-	retval2 = jtagdp_overrun_check(dap);
+
+	if (dap->jtag_pipeline) {
+		uint32_t ctrlstat;
+		bool stalled;
+
+		/* Queue the CTRL/STAT read behind the transactions.  Its ACK is
+		 * checked with theirs, and without any WAIT in the batch its
+		 * value is as good as that of a separate read afterwards.
+		 */
+		retval = jtag_dp_q_read(dap, DP_CTRL_STAT, &ctrlstat);
+		if (retval == ERROR_OK)
+			retval = adi_jtag_finish_read(dap);
+		if (retval != ERROR_OK)
+			goto done;
+
+		retval2 = jtagdp_overrun_check(dap, &stalled);
+		if ((retval2 == ERROR_OK) && !stalled) {
+			dap->round_trips_saved++;
+			retval = jtagdp_check_ctrlstat(dap, ctrlstat);
+			goto done;
+		}
+		/* after WAIT recovery, check CTRL/STAT on its own as usual */
+	} else
+		retval2 = jtagdp_overrun_check(dap, NULL);
+
 	retval = jtagdp_transaction_endcheck(dap);
 
  done:
@@ -685,7 +723,7 @@ static int jtag_dp_run(struct adiv5_dap *dap)
 
 static int jtag_dp_sync(struct adiv5_dap *dap)
 {
-	return jtagdp_overrun_check(dap);
+	return jtagdp_overrun_check(dap, NULL);
 }
 
 /* FIXME don't export ... just initialize as
@@ -85,6 +85,7 @@ static int swd_run_inner(struct adiv5_dap *dap)
 	const struct swd_driver *swd = jtag_interface->swd;
 	int retval;
 
+	jtag_count_queue_flush();
 	retval = swd->run();
 
 	if (retval != ERROR_OK) {
@@ -587,6 +587,8 @@ struct adiv5_dap *dap_init(void)
 		dap->ap[i].tar_autoincr_block = (1<<10);
 	}
 	INIT_LIST_HEAD(&dap->cmd_journal);
+	dap->jtag_pipeline = true;
+	dap->poll_coalesce = true;
 	return dap;
 }
 
@@ -725,6 +727,76 @@ int mem_ap_init(struct adiv5_ap *ap)
 	return ERROR_OK;
 }
 
+/* Larger TAR autoincrement blocks than this are not probed for, they
+ * would hardly save any further TAR writes. */
+#define TAR_AUTOINCR_PROBE_MAX	(1 << 16)
+
+/**
+ * Detect the TAR autoincrement block size of a MEM-AP.
+ *
+ * The ADI spec only guarantees that the low ten bits of TAR increment,
+ * many MEM-APs carry further.  For each power of two from 1 KiB upwards,
+ * a word just below a boundary that is an odd multiple of it is read with
+ * autoincrement enabled; if TAR then holds the boundary the increment
+ * carried across it and the block is at least twice as large.
+ *
+ * @param ap The MEM-AP to probe.
+ * @param address Start of a readable memory region (bus address).
+ * @param size Size of that region; it bounds the largest block detected.
+ */
+int mem_ap_probe_tar_autoincr(struct adiv5_ap *ap, uint32_t address, uint32_t size)
+{
+	struct adiv5_dap *dap = ap->dap;
+	uint32_t block = 1 << 10;
+	int retval;
+
+	retval = mem_ap_setup_csw(ap, CSW_32BIT | CSW_ADDRINC_SINGLE);
+	if (retval != ERROR_OK)
+		return retval;
+
+	for (uint32_t candidate = block; candidate < TAR_AUTOINCR_PROBE_MAX; candidate <<= 1) {
+		uint64_t boundary = ((uint64_t)address + 4 + candidate - 1) & ~(uint64_t)(candidate - 1);
+		uint32_t value, tar;
+
+		if ((boundary / candidate) % 2 == 0)
+			boundary += candidate;
+		if (boundary > (uint64_t)address + size)
+			break;
+
+		retval = dap_queue_ap_write(ap, MEM_AP_REG_TAR, boundary - 4);
+		if (retval == ERROR_OK)
+			retval = dap_queue_ap_read(ap, MEM_AP_REG_DRW, &value);
+		if (retval == ERROR_OK)
+			retval = dap_queue_ap_read(ap, MEM_AP_REG_TAR, &tar);
+		if (retval == ERROR_OK)
+			retval = dap_run(dap);
+
+		/* TAR no longer matches the cache */
+		ap->tar_value = -1;
+
+		if (retval != ERROR_OK)
+			break;
+
+		LOG_DEBUG("MEM-AP %d TAR after 0x%08" PRIx32 ": 0x%08" PRIx32,
+				ap->ap_num, (uint32_t)boundary - 4, tar);
+		if (tar != (uint32_t)boundary)
+			break;
+		block = candidate << 1;
+	}
+
+	if (retval != ERROR_OK) {
+		LOG_DEBUG("MEM-AP %d TAR autoincrement probe failed", ap->ap_num);
+		return retval;
+	}
+
+	if (block != ap->tar_autoincr_block)
+		LOG_INFO("MEM-AP %d TAR autoincrement block %" PRIu32 " bytes (was %" PRIu32 ")",
+				ap->ap_num, block, ap->tar_autoincr_block);
+	ap->tar_autoincr_block = block;
+
+	return ERROR_OK;
+}
+
 /* CID interpretation -- see ARM IHI 0029B section 3
  * and ARM IHI 0031A table 13-3.
  */
@@ -1654,6 +1726,224 @@ COMMAND_HANDLER(dap_ti_be_32_quirks_command)
 	return 0;
 }
 
+COMMAND_HANDLER(dap_pipeline_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+
+	switch (CMD_ARGC) {
+	case 0:
+		break;
+	case 1:
+		if (strcmp(CMD_ARGV[0], "reset") == 0) {
+			dap->run_count = 0;
+			dap->round_trips_saved = 0;
+		} else
+			COMMAND_PARSE_ENABLE(CMD_ARGV[0], dap->jtag_pipeline);
+		break;
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	command_print(CMD_CTX, "JTAG-DP pipelining %s, %u runs, %u round trips saved",
+		dap->jtag_pipeline ? "enabled" : "disabled",
+		dap->run_count, dap->round_trips_saved);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(dap_poll_coalesce_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_ENABLE(CMD_ARGV[0], dap->poll_coalesce);
+
+	command_print(CMD_CTX, "coalesced Cortex-M polling %s",
+		dap->poll_coalesce ? "enabled" : "disabled");
+
+	return ERROR_OK;
+}
+
+/* Run the TAR autoincrement probe on the target's working area.  The probe
+ * only reads, so the area is used as configured, without allocating it:
+ * that works while the core runs and never restores a stale backup. */
+int mem_ap_probe_tar_autoincr_working_area(struct target *target, struct adiv5_ap *ap)
+{
+	uint32_t size = target->working_area_size;
+
+	if (!target->working_area_phys_spec) {
+		LOG_WARNING("TAR autoincrement probe needs a working area with a physical address");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
+
+	if (size > TAR_AUTOINCR_PROBE_MAX)
+		size = TAR_AUTOINCR_PROBE_MAX;
+	size &= ~3;
+	if (size < (2 << 10)) {
+		LOG_WARNING("TAR autoincrement probe needs at least 2 KiB of working area");
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
+
+	/* the physical address is the MEM-AP bus address */
+	return mem_ap_probe_tar_autoincr(ap, target->working_area_phys, size);
+}
+
+COMMAND_HANDLER(dap_tar_autoincr_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+	struct adiv5_ap *ap = dap_ap(dap, dap->apsel);
+	int retval = ERROR_OK;
+
+	switch (CMD_ARGC) {
+	case 0:
+		break;
+	case 1:
+		if (strcmp(CMD_ARGV[0], "probe") == 0) {
+			retval = mem_ap_probe_tar_autoincr_working_area(target, ap);
+		} else {
+			uint32_t block;
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], block);
+			if (block < (1 << 10) || (block & (block - 1)))
+				return ERROR_COMMAND_SYNTAX_ERROR;
+			ap->tar_autoincr_block = block;
+		}
+		break;
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	command_print(CMD_CTX, "AP %d TAR autoincrement block %" PRIu32 " bytes",
+		ap->ap_num, ap->tar_autoincr_block);
+
+	return retval;
+}
+
+COMMAND_HANDLER(dap_tar_autoincr_probe_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_ENABLE(CMD_ARGV[0], dap->tar_autoincr_probe);
+
+	command_print(CMD_CTX, "TAR autoincrement probe at examine %s",
+		dap->tar_autoincr_probe ? "enabled" : "disabled");
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(dap_bench_tar_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+	struct adiv5_ap *ap = dap_ap(dap, dap->apsel);
+	uint32_t length = 16 << 10;
+	int retval = ERROR_OK;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], length);
+	length &= ~3;
+	if (length == 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (target->state != TARGET_HALTED) {
+		LOG_ERROR("target not halted");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	struct working_area *wa = NULL;
+	retval = target_alloc_working_area(target, length, &wa);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Not enough working area for %" PRIu32 " bytes", length);
+		return retval;
+	}
+
+	uint8_t *buffer = calloc(1, length);
+	if (buffer == NULL) {
+		target_free_working_area(target, wa);
+		return ERROR_FAIL;
+	}
+
+	/* the ADI minimum against what is configured or was probed */
+	uint32_t blocks[] = { 1 << 10, ap->tar_autoincr_block };
+	uint32_t saved_block = ap->tar_autoincr_block;
+
+	for (unsigned b = 0; b < ARRAY_SIZE(blocks) && retval == ERROR_OK; b++) {
+		if (b > 0 && blocks[b] == blocks[0])
+			break;
+		ap->tar_autoincr_block = blocks[b];
+
+		for (int op = 0; op < 2 && retval == ERROR_OK; op++) {
+			struct duration bench;
+			unsigned calls = 0;
+
+			duration_start(&bench);
+			do {
+				if (op == 0)
+					retval = mem_ap_read_buf(ap, buffer, 4, length / 4, wa->address);
+				else
+					retval = mem_ap_write_buf(ap, buffer, 4, length / 4, wa->address);
+				duration_measure(&bench);
+				calls++;
+			} while (retval == ERROR_OK && duration_elapsed(&bench) < 0.1);
+
+			if (retval == ERROR_OK)
+				command_print(CMD_CTX, "TAR block %6" PRIu32 ": %s %" PRIu32 " bytes "
+						"%0.3f KiB/s", blocks[b], op == 0 ? "read " : "write",
+						length, duration_kbps(&bench, calls * length));
+			keep_alive();
+		}
+	}
+
+	ap->tar_autoincr_block = saved_block;
+	free(buffer);
+	target_free_working_area(target, wa);
+
+	return retval;
+}
+
+static int dap_bench_read(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	return mem_ap_read_buf(priv, buffer, size, count, address);
+}
+
+static int dap_bench_write(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, const uint8_t *buffer)
+{
+	return mem_ap_write_buf(priv, buffer, size, count, address);
+}
+
+COMMAND_HANDLER(dap_bench_mem_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+	struct target_bench_mem_ops ops = {
+		.name = "mem_ap",
+		.read = dap_bench_read,
+		.write = dap_bench_write,
+		.priv = dap_ap(dap, dap->apsel),
+	};
+
+	/* the working area address is used as MEM-AP bus address */
+	return target_bench_mem(CMD_CTX, target, &ops, CMD_ARGC, CMD_ARGV);
+}
+
 static const struct command_registration dap_commands[] = {
 	{
 		.name = "info",
@@ -1718,6 +2008,55 @@ static const struct command_registration dap_commands[] = {
 		.help = "set/get quirks mode for TI TMS450/TMS570 processors",
 		.usage = "[enable]",
 	},
+	{
+		.name = "pipeline",
+		.handler = dap_pipeline_command,
+		.mode = COMMAND_ANY,
+		.help = "set/get JTAG-DP pipelining of the sticky error check "
+			"and show how many round trips it saved",
+		.usage = "['enable'|'disable'|'reset']",
+	},
+	{
+		.name = "poll_coalesce",
+		.handler = dap_poll_coalesce_command,
+		.mode = COMMAND_ANY,
+		.help = "read the status of all Cortex-M cores on the DAP "
+			"in one transaction when polling",
+		.usage = "['enable'|'disable']",
+	},
+	{
+		.name = "tar_autoincr",
+		.handler = dap_tar_autoincr_command,
+		.mode = COMMAND_EXEC,
+		.help = "set/get the TAR autoincrement block size of the "
+			"currently selected AP, or probe it using the working area",
+		.usage = "[size|'probe']",
+	},
+	{
+		.name = "tar_autoincr_probe",
+		.handler = dap_tar_autoincr_probe_command,
+		.mode = COMMAND_ANY,
+		.help = "probe the TAR autoincrement block size when the "
+			"target is examined",
+		.usage = "['enable'|'disable']",
+	},
+	{
+		.name = "bench_tar",
+		.handler = dap_bench_tar_command,
+		.mode = COMMAND_EXEC,
+		.help = "compare MEM-AP transfer speed with the minimal and the "
+			"current TAR autoincrement block size",
+		.usage = "[length]",
+	},
+	{
+		.name = "bench_mem",
+		.handler = dap_bench_mem_command,
+		.mode = COMMAND_EXEC,
+		.help = "time mem_ap_read_buf/mem_ap_write_buf on the currently "
+			"selected AP for each access size, alignment and length, "
+			"output is CSV",
+		.usage = "['read'|'write'] [length ...]",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
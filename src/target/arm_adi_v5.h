@@ -240,6 +240,27 @@ struct adiv5_dap {
 	 * should be performed before the next access.
 	 */
 	bool do_reconnect;
+
+	/**
+	 * JTAG-DP only: queue the CTRL/STAT sticky error check of run()
+	 * behind the pending transactions, so a run() without WAIT replies
+	 * costs one JTAG queue execution instead of two.
+	 */
+	bool jtag_pipeline;
+
+	/* probe the TAR autoincrement block size when the target is examined */
+	bool tar_autoincr_probe;
+
+	/* read DHCSR of all Cortex-M cores on this DAP in one run when polling */
+	bool poll_coalesce;
+
+	/* incremented by each dap_run(), so results read ahead of time can
+	 * tell whether other transactions happened since */
+	unsigned run_serial;
+
+	/* number of run() calls, and adapter round trips saved by jtag_pipeline */
+	unsigned run_count;
+	unsigned round_trips_saved;
 };
 
 /**
@@ -393,6 +414,7 @@ static inline int dap_queue_ap_abort(struct adiv5_dap *dap, uint8_t *ack)
 static inline int dap_run(struct adiv5_dap *dap)
 {
 	assert(dap->ops != NULL);
+	dap->run_serial++;
 	return dap->ops->run(dap);
 }
 
@@ -469,6 +491,9 @@ int mem_ap_read_buf_noincr(struct adiv5_ap *ap,
 int mem_ap_write_buf_noincr(struct adiv5_ap *ap,
 		const uint8_t *buffer, uint32_t size, uint32_t count, uint32_t address);
 
+/* Detect the TAR autoincrement block size using a readable memory region */
+int mem_ap_probe_tar_autoincr(struct adiv5_ap *ap, uint32_t address, uint32_t size);
+
 /* Create DAP struct */
 struct adiv5_dap *dap_init(void);
 
@@ -496,6 +521,9 @@ int dap_lookup_cs_component(struct adiv5_ap *ap,
 
 struct target;
 
+/* TAR autoincrement probe on the working area of target */
+int mem_ap_probe_tar_autoincr_working_area(struct target *target, struct adiv5_ap *ap);
+
 /* Put debug link into SWD mode */
 int dap_to_swd(struct target *target);
 
@@ -481,6 +481,131 @@ static int cortex_m_debug_entry(struct target *target)
 	return ERROR_OK;
 }
 
+static int cortex_m_poll(struct target *target);
+
+/* A read ahead DHCSR older than this belongs to an earlier round of polling */
+#define DHCSR_PREFETCH_MAX_AGE_MS	10
+
+/* DHCSR bits cleared by reading it */
+#define DHCSR_STICKY_BITS	(S_RESET_ST | S_RETIRE_ST)
+
+/* return the Cortex-M peer of target whose DHCSR can be read along with its own */
+static struct cortex_m_common *cortex_m_poll_peer(struct target *target,
+		struct target *peer)
+{
+	struct adiv5_ap *ap = target_to_cm(target)->armv7m.debug_ap;
+	struct cortex_m_common *cm;
+
+	if (peer == target || peer->type->poll != cortex_m_poll)
+		return NULL;
+	if (!target_was_examined(peer) || !peer->tap->enabled)
+		return NULL;
+
+	cm = target_to_cm(peer);
+	if (cm->common_magic != CORTEX_M_COMMON_MAGIC || cm->dhcsr_no_coalesce)
+		return NULL;
+	if (cm->armv7m.debug_ap == NULL || cm->armv7m.debug_ap == ap
+			|| cm->armv7m.debug_ap->dap != ap->dap)
+		return NULL;
+
+	return cm;
+}
+
+/* Read DHCSR for polling.  With several cores behind one DAP, the first
+ * core polled queues the DHCSR reads of the others with its own; they use
+ * that value when polled right after, unless the DAP was accessed since.
+ * Sticky bits of a value that is not used are merged into the next read.
+ */
+static int cortex_m_poll_read_dhcsr(struct target *target)
+{
+	struct cortex_m_common *cortex_m = target_to_cm(target);
+	struct adiv5_ap *ap = cortex_m->armv7m.debug_ap;
+	struct adiv5_dap *dap = ap->dap;
+	struct cortex_m_common *cm;
+	unsigned peers = 0;
+	int retval;
+
+	if (cortex_m->dhcsr_prefetch_valid) {
+		cortex_m->dhcsr_prefetch_valid = false;
+		if (cortex_m->dhcsr_prefetch_serial == dap->run_serial
+				&& timeval_ms() - cortex_m->dhcsr_prefetch_time <= DHCSR_PREFETCH_MAX_AGE_MS) {
+			cortex_m->dcb_dhcsr = cortex_m->dhcsr_prefetch | cortex_m->dhcsr_sticky;
+			cortex_m->dhcsr_sticky = 0;
+			return ERROR_OK;
+		}
+	}
+
+	if (!dap->poll_coalesce || cortex_m->dhcsr_no_coalesce) {
+		retval = mem_ap_read_atomic_u32(ap, DCB_DHCSR, &cortex_m->dcb_dhcsr);
+		goto done;
+	}
+
+	retval = mem_ap_read_u32(ap, DCB_DHCSR, &cortex_m->dcb_dhcsr);
+	for (struct target *t = all_targets; t && retval == ERROR_OK; t = t->next) {
+		cm = cortex_m_poll_peer(target, t);
+		if (cm == NULL)
+			continue;
+		retval = mem_ap_read_u32(cm->armv7m.debug_ap, DCB_DHCSR, &cm->dhcsr_prefetch);
+		peers++;
+	}
+	if (retval == ERROR_OK)
+		retval = dap_run(dap);
+
+	/* A fault on any core fails the whole run.  Read each core on its own
+	 * to find out which, and leave that one out until it is examined again.
+	 */
+	if (retval != ERROR_OK && peers) {
+		LOG_DEBUG("%s: coalesced DHCSR read failed, reading alone",
+			target_name(target));
+
+		for (struct target *t = all_targets; t; t = t->next) {
+			cm = cortex_m_poll_peer(target, t);
+			if (cm == NULL)
+				continue;
+			cm->dhcsr_prefetch_valid = false;
+			if (mem_ap_read_atomic_u32(cm->armv7m.debug_ap, DCB_DHCSR,
+					&cm->dhcsr_prefetch) != ERROR_OK) {
+				LOG_DEBUG("%s: not coalescing DHCSR reads until examined again",
+					target_name(t));
+				cm->dhcsr_no_coalesce = true;
+				continue;
+			}
+			cm->dhcsr_prefetch_valid = true;
+			cm->dhcsr_sticky |= cm->dhcsr_prefetch & DHCSR_STICKY_BITS;
+		}
+
+		retval = mem_ap_read_atomic_u32(ap, DCB_DHCSR, &cortex_m->dcb_dhcsr);
+		if (retval != ERROR_OK)
+			cortex_m->dhcsr_no_coalesce = true;
+	} else if (peers) {
+		for (struct target *t = all_targets; t; t = t->next) {
+			cm = cortex_m_poll_peer(target, t);
+			if (cm == NULL)
+				continue;
+			cm->dhcsr_prefetch_valid = true;
+			cm->dhcsr_sticky |= cm->dhcsr_prefetch & DHCSR_STICKY_BITS;
+		}
+	}
+
+	/* stamp the read ahead values after the last run above */
+	int64_t now = timeval_ms();
+	for (struct target *t = all_targets; peers && t; t = t->next) {
+		cm = cortex_m_poll_peer(target, t);
+		if (cm == NULL)
+			continue;
+		cm->dhcsr_prefetch_serial = dap->run_serial;
+		cm->dhcsr_prefetch_time = now;
+	}
+
+done:
+	if (retval == ERROR_OK) {
+		cortex_m->dcb_dhcsr |= cortex_m->dhcsr_sticky;
+		cortex_m->dhcsr_sticky = 0;
+	}
+
+	return retval;
+}
+
 static int cortex_m_poll(struct target *target)
 {
 	int detected_failure = ERROR_OK;
@@ -490,7 +615,7 @@ static int cortex_m_poll(struct target *target)
 	struct armv7m_common *armv7m = &cortex_m->armv7m;
 
 	/* Read from Debug Halting Control and Status Register */
-	retval = mem_ap_read_atomic_u32(armv7m->debug_ap, DCB_DHCSR, &cortex_m->dcb_dhcsr);
+	retval = cortex_m_poll_read_dhcsr(target);
 	if (retval != ERROR_OK) {
 		target->state = TARGET_UNKNOWN;
 		return retval;
@@ -1904,6 +2029,9 @@ int cortex_m_examine(struct target *target)
 	struct adiv5_dap *swjdp = cortex_m->armv7m.arm.dap;
 	struct armv7m_common *armv7m = target_to_armv7m(target);
 
+	/* give coalesced polling another try, see cortex_m_poll_read_dhcsr() */
+	cortex_m->dhcsr_no_coalesce = false;
+
 	/* stlink shares the examine handler but does not support
 	 * all its calls */
 	if (!armv7m->stlink) {
@@ -2003,6 +2131,10 @@ int cortex_m_examine(struct target *target)
 			else if (i == 7)
 				/* Cortex-M7 has only 1024 bytes autoincrement range */
 				armv7m->debug_ap->tar_autoincr_block = (1 << 10);
+			else if (armv7m->debug_ap->dap->tar_autoincr_probe)
+				/* nothing known for this core, a failed probe
+				 * leaves the ADI minimum */
+				mem_ap_probe_tar_autoincr_working_area(target, armv7m->debug_ap);
 		}
 
 		/* Configure trace modules */
@@ -165,6 +165,18 @@ struct cortex_m_common {
 
 	/* Context information */
 	uint32_t dcb_dhcsr;
+
+	/* DHCSR read on behalf of this core while polling another core on
+	 * the same DAP, see cortex_m_poll_read_dhcsr() */
+	uint32_t dhcsr_prefetch;
+	bool dhcsr_prefetch_valid;
+	unsigned dhcsr_prefetch_serial;
+	int64_t dhcsr_prefetch_time;
+	/* sticky bits read ahead, kept until the next poll even if the
+	 * read ahead value itself is dropped */
+	uint32_t dhcsr_sticky;
+	/* read alone, the last coalesced read of this core failed */
+	bool dhcsr_no_coalesce;
 	uint32_t nvic_dfsr;  /* Debug Fault Status Register - shows reason for debug halt */
 	uint32_t nvic_icsr;  /* Interrupt Control State Register - shows active and pending IRQ */
 
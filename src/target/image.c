@@ -32,6 +32,7 @@
 #include "image.h"
 #include "target.h"
 #include <helper/log.h>
+#include <helper/binarybuffer.h>
 
 /* convert ELF header field to host endianness */
 #define field16(elf, field) \
@@ -115,6 +116,176 @@ static int identify_image_type(struct image *image, const char *type_string, con
 	return ERROR_OK;
 }
 
+/* IHEX and S19 images aren't buffered in memory.  While the file is first
+ * parsed, the position of a data record is remembered roughly every
+ * IMAGE_RECORD_MARK_INTERVAL bytes of each section; reads seek back to the
+ * nearest mark and decode just the records covering the requested window.
+ */
+#define IMAGE_RECORD_MARK_INTERVAL	(4096)
+
+static int image_mark_record(struct image_record_index *index,
+	int section, uint32_t offset, size_t position)
+{
+	if (index->num_marks > 0) {
+		struct image_record_mark *last = &index->marks[index->num_marks - 1];
+
+		if ((last->section == section) &&
+			(offset < last->offset + IMAGE_RECORD_MARK_INTERVAL))
+			return ERROR_OK;
+	}
+
+	if (index->num_marks == index->max_marks) {
+		int max_marks = index->max_marks ? (index->max_marks * 2) : 64;
+		struct image_record_mark *marks;
+
+		marks = realloc(index->marks, max_marks * sizeof(struct image_record_mark));
+		if (marks == NULL) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+		index->marks = marks;
+		index->max_marks = max_marks;
+	}
+
+	index->marks[index->num_marks].section = section;
+	index->marks[index->num_marks].offset = offset;
+	index->marks[index->num_marks].position = position;
+	index->num_marks++;
+
+	return ERROR_OK;
+}
+
+static void image_free_record_index(struct image_record_index *index)
+{
+	free(index->marks);
+	index->marks = NULL;
+	index->num_marks = 0;
+	index->max_marks = 0;
+	index->cursor.section = -1;
+}
+
+/* decode the payload of a data record, returns false for any other record */
+static bool image_record_data(enum image_type type, const char *line,
+	uint8_t *data, uint32_t *count)
+{
+	uint32_t record_type;
+	uint32_t length;
+	size_t bytes_read;
+
+	if (type == IMAGE_IHEX) {
+		if ((sscanf(line, ":%2" SCNx32 "%*4x%2" SCNx32, &length, &record_type) != 2)
+			|| (record_type != 0))
+			return false;
+		bytes_read = 9;
+	} else {
+		if ((sscanf(line, "S%1" SCNx32 "%2" SCNx32, &record_type, &length) != 2)
+			|| (record_type < 1) || (record_type > 3))
+			return false;
+		/* the S19 byte count includes the address and the checksum */
+		if (length < record_type + 2)
+			return false;
+		bytes_read = 4 + 2 * (record_type + 1);
+		length -= record_type + 2;
+	}
+
+	*count = unhexify(data, &line[bytes_read], length);
+
+	return *count == length;
+}
+
+static int image_read_record_section(struct image *image,
+	struct fileio *fileio,
+	struct image_record_index *index,
+	int section,
+	uint32_t offset,
+	uint32_t size,
+	uint8_t *buffer,
+	size_t *size_read)
+{
+	struct image_record_mark mark = { .section = -1 };
+	int retval;
+
+	*size_read = 0;
+	if (size == 0)
+		return ERROR_OK;
+
+	/* find the last mark at or before the requested offset */
+	int low = 0, high = index->num_marks;
+	while (low < high) {
+		int mid = (low + high) / 2;
+		struct image_record_mark *m = &index->marks[mid];
+
+		if ((m->section < section) ||
+			((m->section == section) && (m->offset <= offset)))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if ((low > 0) && (index->marks[low - 1].section == section))
+		mark = index->marks[low - 1];
+
+	/* sequential reads pick up where the previous one stopped */
+	if ((index->cursor.section == section) && (index->cursor.offset <= offset)
+		&& ((mark.section != section) || (index->cursor.offset > mark.offset)))
+		mark = index->cursor;
+
+	if (mark.section != section) {
+		LOG_ERROR("no record found for section %d offset 0x%8.8" PRIx32, section, offset);
+		return ERROR_IMAGE_FORMAT_ERROR;
+	}
+
+	retval = fileio_seek(fileio, mark.position);
+	if (retval != ERROR_OK)
+		return retval;
+
+	char *line = malloc(1023);
+	if (line == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	uint32_t record_offset = mark.offset;
+	while (*size_read < size) {
+		uint8_t data[256];
+		uint32_t count;
+		size_t position;
+
+		retval = fileio_tell(fileio, &position);
+		if (retval != ERROR_OK)
+			break;
+		retval = fileio_fgets(fileio, 1023, line);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("premature end of image file while reading section %d", section);
+			retval = ERROR_IMAGE_FORMAT_ERROR;
+			break;
+		}
+
+		if (!image_record_data(image->type, line, data, &count))
+			continue;
+
+		uint32_t want = offset + *size_read;
+		if (record_offset + count > want) {
+			uint32_t skip = want - record_offset;
+			uint32_t n = count - skip;
+
+			if (n > size - *size_read)
+				n = size - *size_read;
+			memcpy(buffer + *size_read, data + skip, n);
+			*size_read += n;
+		}
+
+		index->cursor.section = section;
+		index->cursor.offset = record_offset;
+		index->cursor.position = position;
+
+		record_offset += count;
+	}
+
+	free(line);
+
+	return retval;
+}
+
 static int image_ihex_buffer_complete_inner(struct image *image,
 	char *lpszLine,
 	struct imagesection *section)
@@ -122,27 +293,21 @@ static int image_ihex_buffer_complete_inner(struct image *image,
 	struct image_ihex *ihex = image->type_private;
 	struct fileio *fileio = ihex->fileio;
 	uint32_t full_address = 0x0;
-	uint32_t cooked_bytes;
+	size_t position;
+	int retval;
 	int i;
 
 	/* we can't determine the number of sections that we'll have to create ahead of time,
 	 * so we locally hold them until parsing is finished */
 
-	size_t filesize;
-	int retval;
-	retval = fileio_size(fileio, &filesize);
-	if (retval != ERROR_OK)
-		return retval;
-
-	ihex->buffer = malloc(filesize >> 1);
-	cooked_bytes = 0x0;
 	image->num_sections = 0;
-	section[image->num_sections].private = &ihex->buffer[cooked_bytes];
+	section[image->num_sections].private = NULL;
 	section[image->num_sections].base_address = 0x0;
 	section[image->num_sections].size = 0x0;
 	section[image->num_sections].flags = 0;
 
-	while (fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK) {
+	while (fileio_tell(fileio, &position) == ERROR_OK
+			&& fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK) {
 		uint32_t count;
 		uint32_t address;
 		uint32_t record_type;
@@ -178,21 +343,23 @@ static int image_ihex_buffer_complete_inner(struct image *image,
 					}
 					section[image->num_sections].size = 0x0;
 					section[image->num_sections].flags = 0;
-					section[image->num_sections].private =
-						&ihex->buffer[cooked_bytes];
+					section[image->num_sections].private = NULL;
 				}
 				section[image->num_sections].base_address =
 					(full_address & 0xffff0000) | address;
 				full_address = (full_address & 0xffff0000) | address;
 			}
 
+			retval = image_mark_record(&ihex->index, image->num_sections,
+					section[image->num_sections].size, position);
+			if (retval != ERROR_OK)
+				return retval;
+
 			while (count-- > 0) {
 				unsigned value;
 				sscanf(&lpszLine[bytes_read], "%2x", &value);
-				ihex->buffer[cooked_bytes] = (uint8_t)value;
-				cal_checksum += (uint8_t)ihex->buffer[cooked_bytes];
+				cal_checksum += (uint8_t)value;
 				bytes_read += 2;
-				cooked_bytes += 1;
 				section[image->num_sections].size += 1;
 				full_address++;
 			}
@@ -232,8 +399,7 @@ static int image_ihex_buffer_complete_inner(struct image *image,
 					}
 					section[image->num_sections].size = 0x0;
 					section[image->num_sections].flags = 0;
-					section[image->num_sections].private =
-						&ihex->buffer[cooked_bytes];
+					section[image->num_sections].private = NULL;
 				}
 				section[image->num_sections].base_address =
 					(full_address & 0xffff) | (upper_address << 4);
@@ -271,8 +437,7 @@ static int image_ihex_buffer_complete_inner(struct image *image,
 					}
 					section[image->num_sections].size = 0x0;
 					section[image->num_sections].flags = 0;
-					section[image->num_sections].private =
-						&ihex->buffer[cooked_bytes];
+					section[image->num_sections].private = NULL;
 				}
 				section[image->num_sections].base_address =
 					(full_address & 0xffff) | (upper_address << 16);
@@ -511,27 +676,21 @@ static int image_mot_buffer_complete_inner(struct image *image,
 	struct image_mot *mot = image->type_private;
 	struct fileio *fileio = mot->fileio;
 	uint32_t full_address = 0x0;
-	uint32_t cooked_bytes;
+	size_t position;
+	int retval;
 	int i;
 
 	/* we can't determine the number of sections that we'll have to create ahead of time,
 	 * so we locally hold them until parsing is finished */
 
-	int retval;
-	size_t filesize;
-	retval = fileio_size(fileio, &filesize);
-	if (retval != ERROR_OK)
-		return retval;
-
-	mot->buffer = malloc(filesize >> 1);
-	cooked_bytes = 0x0;
 	image->num_sections = 0;
-	section[image->num_sections].private = &mot->buffer[cooked_bytes];
+	section[image->num_sections].private = NULL;
 	section[image->num_sections].base_address = 0x0;
 	section[image->num_sections].size = 0x0;
 	section[image->num_sections].flags = 0;
 
-	while (fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK) {
+	while (fileio_tell(fileio, &position) == ERROR_OK
+			&& fileio_fgets(fileio, 1023, lpszLine) == ERROR_OK) {
 		uint32_t count;
 		uint32_t address;
 		uint32_t record_type;
@@ -602,20 +761,22 @@ static int image_mot_buffer_complete_inner(struct image *image,
 					image->num_sections++;
 					section[image->num_sections].size = 0x0;
 					section[image->num_sections].flags = 0;
-					section[image->num_sections].private =
-						&mot->buffer[cooked_bytes];
+					section[image->num_sections].private = NULL;
 				}
 				section[image->num_sections].base_address = address;
 				full_address = address;
 			}
 
+			retval = image_mark_record(&mot->index, image->num_sections,
+					section[image->num_sections].size, position);
+			if (retval != ERROR_OK)
+				return retval;
+
 			while (count-- > 0) {
 				unsigned value;
 				sscanf(&lpszLine[bytes_read], "%2x", &value);
-				mot->buffer[cooked_bytes] = (uint8_t)value;
-				cal_checksum += (uint8_t)mot->buffer[cooked_bytes];
+				cal_checksum += (uint8_t)value;
 				bytes_read += 2;
-				cooked_bytes += 1;
 				section[image->num_sections].size += 1;
 				full_address++;
 			}
@@ -720,7 +881,8 @@ int image_open(struct image *image, const char *url, const char *type_string)
 	} else if (image->type == IMAGE_IHEX) {
 		struct image_ihex *image_ihex;
 
-		image_ihex = image->type_private = malloc(sizeof(struct image_ihex));
+		image_ihex = image->type_private = calloc(1, sizeof(struct image_ihex));
+		image_ihex->index.cursor.section = -1;
 
 		retval = fileio_open(&image_ihex->fileio, url, FILEIO_READ, FILEIO_TEXT);
 		if (retval != ERROR_OK)
@@ -730,6 +892,7 @@ int image_open(struct image *image, const char *url, const char *type_string)
 		if (retval != ERROR_OK) {
 			LOG_ERROR(
 				"failed buffering IHEX image, check server output for additional information");
+			image_free_record_index(&image_ihex->index);
 			fileio_close(image_ihex->fileio);
 			return retval;
 		}
@@ -771,7 +934,8 @@ int image_open(struct image *image, const char *url, const char *type_string)
 	} else if (image->type == IMAGE_SRECORD) {
 		struct image_mot *image_mot;
 
-		image_mot = image->type_private = malloc(sizeof(struct image_mot));
+		image_mot = image->type_private = calloc(1, sizeof(struct image_mot));
+		image_mot->index.cursor.section = -1;
 
 		retval = fileio_open(&image_mot->fileio, url, FILEIO_READ, FILEIO_TEXT);
 		if (retval != ERROR_OK)
@@ -781,6 +945,7 @@ int image_open(struct image *image, const char *url, const char *type_string)
 		if (retval != ERROR_OK) {
 			LOG_ERROR(
 				"failed buffering S19 image, check server output for additional information");
+			image_free_record_index(&image_mot->index);
 			fileio_close(image_mot->fileio);
 			return retval;
 		}
@@ -842,10 +1007,10 @@ int image_read_section(struct image *image,
 		if (retval != ERROR_OK)
 			return retval;
 	} else if (image->type == IMAGE_IHEX) {
-		memcpy(buffer, (uint8_t *)image->sections[section].private + offset, size);
-		*size_read = size;
+		struct image_ihex *image_ihex = image->type_private;
 
-		return ERROR_OK;
+		return image_read_record_section(image, image_ihex->fileio, &image_ihex->index,
+				section, offset, size, buffer, size_read);
 	} else if (image->type == IMAGE_ELF)
 		return image_elf_read_section(image, section, offset, size, buffer, size_read);
 	else if (image->type == IMAGE_MEMORY) {
@@ -887,10 +1052,10 @@ int image_read_section(struct image *image,
 			address += (size_in_cache > size) ? size : size_in_cache;
 		}
 	} else if (image->type == IMAGE_SRECORD) {
-		memcpy(buffer, (uint8_t *)image->sections[section].private + offset, size);
-		*size_read = size;
+		struct image_mot *image_mot = image->type_private;
 
-		return ERROR_OK;
+		return image_read_record_section(image, image_mot->fileio, &image_mot->index,
+				section, offset, size, buffer, size_read);
 	} else if (image->type == IMAGE_BUILDER) {
 		memcpy(buffer, (uint8_t *)image->sections[section].private + offset, size);
 		*size_read = size;
@@ -949,10 +1114,7 @@ void image_close(struct image *image)
 
 		fileio_close(image_ihex->fileio);
 
-		if (image_ihex->buffer) {
-			free(image_ihex->buffer);
-			image_ihex->buffer = NULL;
-		}
+		image_free_record_index(&image_ihex->index);
 	} else if (image->type == IMAGE_ELF) {
 		struct image_elf *image_elf = image->type_private;
 
@@ -979,10 +1141,7 @@ void image_close(struct image *image)
 
 		fileio_close(image_mot->fileio);
 
-		if (image_mot->buffer) {
-			free(image_mot->buffer);
-			image_mot->buffer = NULL;
-		}
+		image_free_record_index(&image_mot->index);
 	} else if (image->type == IMAGE_BUILDER) {
 		int i;
 
@@ -1003,25 +1162,88 @@ void image_close(struct image *image)
 	}
 }
 
+/* CRC32 as per gdb: polynomial 0x04c11db7, MSB first, no reflection and
+ * no final inversion.  crc32_table[0] is the classic bytewise table,
+ * crc32_table[k] advances a byte through k further zero bytes so that
+ * eight bytes can be folded in per step ("slice-by-8").
+ */
+static uint32_t crc32_table[8][256];
+static bool crc32_slice_by_8;
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *buffer, uint32_t nbytes)
+{
+	while (nbytes--)
+		crc = (crc << 8) ^ crc32_table[0][((crc >> 24) ^ *buffer++) & 255];
+
+	return crc;
+}
+
+static uint32_t crc32_sliced(uint32_t crc, const uint8_t *buffer, uint32_t nbytes)
+{
+	while (nbytes >= 8) {
+		crc ^= be_to_h_u32(buffer);
+		crc = crc32_table[7][crc >> 24] ^
+			crc32_table[6][(crc >> 16) & 255] ^
+			crc32_table[5][(crc >> 8) & 255] ^
+			crc32_table[4][crc & 255] ^
+			crc32_table[3][buffer[4]] ^
+			crc32_table[2][buffer[5]] ^
+			crc32_table[1][buffer[6]] ^
+			crc32_table[0][buffer[7]];
+		buffer += 8;
+		nbytes -= 8;
+	}
+
+	return crc32_bytewise(crc, buffer, nbytes);
+}
+
+static void crc32_init(void)
+{
+	int i, j, k;
+	uint32_t c;
+
+	for (i = 0; i < 256; i++) {
+		/* as per gdb */
+		for (c = i << 24, j = 8; j > 0; --j)
+			c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
+		crc32_table[0][i] = c;
+	}
+
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++) {
+			c = crc32_table[k - 1][i];
+			crc32_table[k][i] = (c << 8) ^ crc32_table[0][c >> 24];
+		}
+	}
+
+	/* self-test: the sliced CRC must agree with the bytewise one for
+	 * every length and alignment, otherwise stick to the latter */
+	uint8_t pattern[67];
+	for (i = 0; i < (int)sizeof(pattern); i++)
+		pattern[i] = i * 0x9d + 0x31;
+
+	crc32_slice_by_8 = true;
+	for (i = 0; i < 8 && crc32_slice_by_8; i++) {
+		for (j = 0; i + j <= (int)sizeof(pattern); j++) {
+			if (crc32_sliced(0xffffffff, pattern + i, j) !=
+					crc32_bytewise(0xffffffff, pattern + i, j)) {
+				LOG_ERROR("slice-by-8 CRC self-test failed, using bytewise CRC");
+				crc32_slice_by_8 = false;
+				break;
+			}
+		}
+	}
+}
+
 int image_calculate_checksum(uint8_t *buffer, uint32_t nbytes, uint32_t *checksum)
 {
 	uint32_t crc = 0xffffffff;
 	LOG_DEBUG("Calculating checksum");
 
-	static uint32_t crc32_table[256];
-
 	static bool first_init;
 	if (!first_init) {
-		/* Initialize the CRC table and the decoding table.  */
-		int i, j;
-		unsigned int c;
-		for (i = 0; i < 256; i++) {
-			/* as per gdb */
-			for (c = i << 24, j = 8; j > 0; --j)
-				c = c & 0x80000000 ? (c << 1) ^ 0x04c11db7 : (c << 1);
-			crc32_table[i] = c;
-		}
-
+		/* Initialize the CRC tables and the decoding table.  */
+		crc32_init();
 		first_init = true;
 	}
 
@@ -1030,10 +1252,11 @@ int image_calculate_checksum(uint8_t *buffer, uint32_t nbytes, uint32_t *checksu
 		if (run > 32768)
 			run = 32768;
 		nbytes -= run;
-		while (run--) {
-			/* as per gdb */
-			crc = (crc << 8) ^ crc32_table[((crc >> 24) ^ *buffer++) & 255];
-		}
+		if (crc32_slice_by_8)
+			crc = crc32_sliced(crc, buffer, run);
+		else
+			crc = crc32_bytewise(crc, buffer, run);
+		buffer += run;
 		keep_alive();
 	}
 
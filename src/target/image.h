@@ -67,9 +67,23 @@ struct image_binary {
 	struct fileio *fileio;
 };
 
+/* file position of a data record in an IHEX or S19 image */
+struct image_record_mark {
+	int section;
+	uint32_t offset;	/* section offset of the record's first data byte */
+	size_t position;
+};
+
+struct image_record_index {
+	struct image_record_mark *marks;
+	int num_marks;
+	int max_marks;
+	struct image_record_mark cursor;	/* record the last read stopped in */
+};
+
 struct image_ihex {
 	struct fileio *fileio;
-	uint8_t *buffer;
+	struct image_record_index index;
 };
 
 struct image_memory {
@@ -88,7 +102,7 @@ struct image_elf {
 
 struct image_mot {
 	struct fileio *fileio;
-	uint8_t *buffer;
+	struct image_record_index index;
 };
 
 int image_open(struct image *image, const char *url, const char *type_string);
@@ -1077,6 +1077,7 @@ int target_write_memory(struct target *target,
 		LOG_ERROR("Target %s doesn't support write_memory", target_name(target));
 		return ERROR_FAIL;
 	}
+	target->memory_write_count++;
 	return target->type->write_memory(target, address, size, count, buffer);
 }
 
@@ -1091,6 +1092,7 @@ int target_write_phys_memory(struct target *target,
 		LOG_ERROR("Target %s doesn't support write_phys_memory", target_name(target));
 		return ERROR_FAIL;
 	}
+	target->memory_write_count++;
 	return target->type->write_phys_memory(target, address, size, count, buffer);
 }
 
@@ -1499,6 +1501,10 @@ int target_unregister_timer_callback(int (*callback)(void *priv), void *priv)
 
 	for (struct target_timer_callback *c = target_timer_callbacks;
 	     c; c = c->next) {
+		/* an entry re-registered from its own callback comes after
+		 * the removed one */
+		if (c->removed)
+			continue;
 		if ((c->callback == callback) && (c->priv == priv)) {
 			c->removed = true;
 			return ERROR_OK;
@@ -1634,6 +1640,28 @@ int target_call_timer_callbacks_now(void)
 	return target_call_timer_callbacks_check_time(0);
 }
 
+int target_timer_next_event(void)
+{
+	struct timeval now;
+	int64_t next = -1;
+
+	gettimeofday(&now, NULL);
+
+	for (struct target_timer_callback *c = target_timer_callbacks; c; c = c->next) {
+		if (c->removed || !c->callback)
+			continue;
+
+		int64_t us = (int64_t)(c->when.tv_sec - now.tv_sec) * 1000000
+			+ (c->when.tv_usec - now.tv_usec);
+		/* round up, waking early would just spin */
+		int64_t ms = us > 0 ? (us + 999) / 1000 : 0;
+		if (next < 0 || ms < next)
+			next = ms;
+	}
+
+	return next > INT32_MAX ? INT32_MAX : (int)next;
+}
+
 /* Prints the working area layout for debug purposes */
 static void print_wa_layout(struct target *target)
 {
@@ -2051,6 +2079,8 @@ int target_write_buffer(struct target *target, target_addr_t address, uint32_t s
 		return ERROR_FAIL;
 	}
 
+	/* write_buffer methods need not go through target_write_memory() */
+	target->memory_write_count++;
 	return target->type->write_buffer(target, address, size, buffer);
 }
 
@@ -3252,6 +3282,10 @@ static COMMAND_HELPER(parse_load_image_command_CMD_ARGV, struct image *image,
 	return ERROR_OK;
 }
 
+/* images are transferred in windows of at most this many bytes, so
+ * large sections never have to be held in memory as a whole */
+#define IMAGE_WINDOW_SIZE	(1024 * 1024)
+
 COMMAND_HANDLER(handle_load_image_command)
 {
 	uint8_t *buffer;
@@ -3275,56 +3309,61 @@ COMMAND_HANDLER(handle_load_image_command)
 	if (image_open(&image, CMD_ARGV[0], (CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL) != ERROR_OK)
 		return ERROR_FAIL;
 
+	buffer = malloc(IMAGE_WINDOW_SIZE);
+	if (buffer == NULL) {
+		command_print(CMD_CTX, "error allocating image buffer");
+		image_close(&image);
+		return ERROR_FAIL;
+	}
+
 	image_size = 0x0;
 	retval = ERROR_OK;
 	for (i = 0; i < image.num_sections; i++) {
-		buffer = malloc(image.sections[i].size);
-		if (buffer == NULL) {
-			command_print(CMD_CTX,
-						  "error allocating buffer for section (%d bytes)",
-						  (int)(image.sections[i].size));
-			retval = ERROR_FAIL;
-			break;
-		}
-
-		retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt);
-		if (retval != ERROR_OK) {
-			free(buffer);
-			break;
-		}
-
-		uint32_t offset = 0;
-		uint32_t length = buf_cnt;
+		target_addr_t base = image.sections[i].base_address;
+		uint32_t section_size = image.sections[i].size;
+		uint32_t written = 0;
 
 		/* DANGER!!! beware of unsigned comparision here!!! */
 
-		if ((image.sections[i].base_address + buf_cnt >= min_address) &&
-				(image.sections[i].base_address < max_address)) {
+		if ((base + section_size < min_address) || (base >= max_address))
+			continue;
 
-			if (image.sections[i].base_address < min_address) {
-				/* clip addresses below */
-				offset += min_address-image.sections[i].base_address;
-				length -= offset;
-			}
+		/* clip addresses below and above */
+		uint32_t start = 0;
+		uint32_t end = section_size;
+		if (base < min_address)
+			start = min_address - base;
+		if (base + section_size > max_address)
+			end -= (base + section_size) - max_address;
 
-			if (image.sections[i].base_address + buf_cnt > max_address)
-				length -= (image.sections[i].base_address + buf_cnt)-max_address;
+		for (uint32_t offset = start; offset < end; offset += buf_cnt) {
+			uint32_t length = end - offset;
+			if (length > IMAGE_WINDOW_SIZE)
+				length = IMAGE_WINDOW_SIZE;
 
-			retval = target_write_buffer(target,
-					image.sections[i].base_address + offset, length, buffer + offset);
-			if (retval != ERROR_OK) {
-				free(buffer);
+			retval = image_read_section(&image, i, offset, length, buffer, &buf_cnt);
+			if (retval != ERROR_OK)
+				break;
+			if (buf_cnt == 0) {
+				retval = ERROR_FAIL;
 				break;
 			}
-			image_size += length;
-			command_print(CMD_CTX, "%u bytes written at address " TARGET_ADDR_FMT "",
-					(unsigned int)length,
-					image.sections[i].base_address + offset);
+
+			retval = target_write_buffer(target, base + offset, buf_cnt, buffer);
+			if (retval != ERROR_OK)
+				break;
+			written += buf_cnt;
 		}
+		if (retval != ERROR_OK)
+			break;
 
-		free(buffer);
+		image_size += written;
+		command_print(CMD_CTX, "%u bytes written at address " TARGET_ADDR_FMT "",
+				(unsigned int)written, base + start);
 	}
 
+	free(buffer);
+
 	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
 		command_print(CMD_CTX, "downloaded %" PRIu32 " bytes "
 				"in %fs (%0.3f KiB/s)", image_size,
@@ -3446,39 +3485,49 @@ static COMMAND_HELPER(handle_verify_image_command_internal, enum verify_mode ver
 	if (retval != ERROR_OK)
 		return retval;
 
+	buffer = malloc(IMAGE_WINDOW_SIZE);
+	if (buffer == NULL) {
+		command_print(CMD_CTX, "error allocating image buffer");
+		image_close(&image);
+		return ERROR_FAIL;
+	}
+
 	image_size = 0x0;
 	int diffs = 0;
 	retval = ERROR_OK;
 	for (i = 0; i < image.num_sections; i++) {
-		buffer = malloc(image.sections[i].size);
-		if (buffer == NULL) {
-			command_print(CMD_CTX,
-					"error allocating buffer for section (%d bytes)",
-					(int)(image.sections[i].size));
-			break;
-		}
-		retval = image_read_section(&image, i, 0x0, image.sections[i].size, buffer, &buf_cnt);
-		if (retval != ERROR_OK) {
-			free(buffer);
-			break;
+		if (verify < IMAGE_VERIFY) {
+			command_print(CMD_CTX, "address " TARGET_ADDR_FMT " length 0x%08" PRIx32,
+						  image.sections[i].base_address,
+						  image.sections[i].size);
+			image_size += image.sections[i].size;
+			continue;
 		}
 
-		if (verify >= IMAGE_VERIFY) {
+		for (uint32_t offset = 0; offset < image.sections[i].size; offset += buf_cnt) {
+			target_addr_t address = image.sections[i].base_address + offset;
+			uint32_t length = image.sections[i].size - offset;
+			if (length > IMAGE_WINDOW_SIZE)
+				length = IMAGE_WINDOW_SIZE;
+
+			retval = image_read_section(&image, i, offset, length, buffer, &buf_cnt);
+			if (retval != ERROR_OK)
+				goto done;
+			if (buf_cnt == 0) {
+				retval = ERROR_FAIL;
+				goto done;
+			}
+
 			/* calculate checksum of image */
 			retval = image_calculate_checksum(buffer, buf_cnt, &checksum);
-			if (retval != ERROR_OK) {
-				free(buffer);
-				break;
-			}
+			if (retval != ERROR_OK)
+				goto done;
 
-			retval = target_checksum_memory(target, image.sections[i].base_address, buf_cnt, &mem_checksum);
-			if (retval != ERROR_OK) {
-				free(buffer);
-				break;
-			}
+			retval = target_checksum_memory(target, address, buf_cnt, &mem_checksum);
+			if (retval != ERROR_OK)
+				goto done;
 			if ((checksum != mem_checksum) && (verify == IMAGE_CHECKSUM_ONLY)) {
 				LOG_ERROR("checksum mismatch");
-				free(buffer);
 				retval = ERROR_FAIL;
 				goto done;
 			}
@@ -3498,7 +3547,7 @@ static COMMAND_HELPER(handle_verify_image_command_internal, enum verify_mode ver
 					size *= 4;
 					count /= 4;
 				}
-				retval = target_read_memory(target, image.sections[i].base_address, size, count, data);
+				retval = target_read_memory(target, address, size, count, data);
 				if (retval == ERROR_OK) {
 					uint32_t t;
 					for (t = 0; t < buf_cnt; t++) {
@@ -3506,13 +3555,12 @@ static COMMAND_HELPER(handle_verify_image_command_internal, enum verify_mode ver
 							command_print(CMD_CTX,
 										  "diff %d address 0x%08x. Was 0x%02x instead of 0x%02x",
 										  diffs,
-										  (unsigned)(t + image.sections[i].base_address),
+										  (unsigned)(t + address),
 										  data[t],
 										  buffer[t]);
 							if (diffs++ >= 127) {
 								command_print(CMD_CTX, "More than 128 errors, the rest are not printed.");
 								free(data);
-								free(buffer);
 								goto done;
 							}
 						}
@@ -3521,18 +3569,14 @@ static COMMAND_HELPER(handle_verify_image_command_internal, enum verify_mode ver
 				}
 				free(data);
 			}
-		} else {
-			command_print(CMD_CTX, "address " TARGET_ADDR_FMT " length 0x%08zx",
-						  image.sections[i].base_address,
-						  buf_cnt);
-		}
 
-		free(buffer);
-		image_size += buf_cnt;
+			image_size += buf_cnt;
+		}
 	}
 	if (diffs > 0)
 		command_print(CMD_CTX, "No more differences found.");
 done:
+	free(buffer);
 	if (diffs > 0)
 		retval = ERROR_FAIL;
 	if ((ERROR_OK == retval) && (duration_measure(&bench) == ERROR_OK)) {
@@ -6164,6 +6208,210 @@ nextw:
 	return retval;
 }
 
+/* each combination is repeated for at least this long */
+#define BENCH_MEM_MIN_TIME	0.1
+
+int target_bench_mem(struct command_context *cmd_ctx, struct target *target,
+		const struct target_bench_mem_ops *ops, unsigned argc, const char **argv)
+{
+	static const uint32_t default_lengths[] = { 4, 64, 256, 1024 };
+	const uint32_t *lengths = default_lengths;
+	unsigned num_lengths = ARRAY_SIZE(default_lengths);
+	uint32_t *parsed_lengths = NULL;
+	bool do_read = true, do_write = true;
+	uint32_t max_length = 0;
+	int retval = ERROR_OK;
+
+	if (argc > 0 && strcmp(argv[0], "read") == 0) {
+		do_write = false;
+		argc--;
+		argv++;
+	} else if (argc > 0 && strcmp(argv[0], "write") == 0) {
+		do_read = false;
+		argc--;
+		argv++;
+	}
+
+	if (argc > 0) {
+		parsed_lengths = malloc(argc * sizeof(uint32_t));
+		if (parsed_lengths == NULL)
+			return ERROR_FAIL;
+		for (unsigned i = 0; i < argc; i++) {
+			retval = parse_u32(argv[i], &parsed_lengths[i]);
+			if (retval != ERROR_OK || parsed_lengths[i] == 0) {
+				free(parsed_lengths);
+				return ERROR_COMMAND_SYNTAX_ERROR;
+			}
+		}
+		lengths = parsed_lengths;
+		num_lengths = argc;
+	}
+
+	if (target->state != TARGET_HALTED) {
+		LOG_ERROR("target not halted");
+		free(parsed_lengths);
+		return ERROR_TARGET_NOT_HALTED;
+	}
+
+	for (unsigned i = 0; i < num_lengths; i++)
+		max_length = MAX(max_length, lengths[i]);
+
+	/* room for the largest transfer at every offset */
+	struct working_area *wa = NULL;
+	retval = target_alloc_working_area(target, max_length + 4, &wa);
+	if (retval != ERROR_OK) {
+		LOG_ERROR("Not enough working area for %" PRIu32 " bytes", max_length + 4);
+		free(parsed_lengths);
+		return retval;
+	}
+
+	uint8_t *buffer = malloc(max_length);
+	if (buffer == NULL) {
+		target_free_working_area(target, wa);
+		free(parsed_lengths);
+		return ERROR_FAIL;
+	}
+	for (uint32_t i = 0; i < max_length; i++)
+		buffer[i] = rand();
+
+	command_print(cmd_ctx, "path,op,size,offset,length,status,calls,seconds,"
+			"bytes_per_s,flushes_per_call,usb_per_call");
+
+	for (int op = 0; op < 2; op++) {
+		if ((op == 0 && !do_read) || (op == 1 && !do_write))
+			continue;
+
+		for (unsigned l = 0; l < num_lengths; l++) {
+			for (uint32_t size = 1; size <= (ops->bytes_only ? 1 : 4); size *= 2) {
+				for (uint32_t offset = 0; offset < 4; offset++) {
+					uint32_t count = lengths[l] / size;
+					unsigned calls = 0;
+					const char *status = "ok";
+					struct duration bench;
+
+					if (count == 0)
+						continue;
+
+					int flushes = jtag_get_flush_queue_count();
+					unsigned usb = jtag_get_usb_transfer_count();
+
+					duration_start(&bench);
+					do {
+						if (op == 0)
+							retval = ops->read(ops->priv, wa->address + offset,
+									size, count, buffer);
+						else
+							retval = ops->write(ops->priv, wa->address + offset,
+									size, count, buffer);
+						duration_measure(&bench);
+						if (retval != ERROR_OK)
+							break;
+						calls++;
+					} while (duration_elapsed(&bench) < BENCH_MEM_MIN_TIME);
+
+					if (retval == ERROR_TARGET_UNALIGNED_ACCESS)
+						status = "unaligned";
+					else if (retval != ERROR_OK)
+						status = "error";
+
+					float seconds = duration_elapsed(&bench);
+					flushes = jtag_get_flush_queue_count() - flushes;
+					usb = jtag_get_usb_transfer_count() - usb;
+
+					command_print(cmd_ctx, "%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu32
+							",%s,%u,%.6f,%.0f,%.2f,%.2f",
+							ops->name, op == 0 ? "read" : "write",
+							size * 8, offset, count * size, status, calls, seconds,
+							calls && seconds > 0 ? calls * count * size / seconds : 0.0,
+							calls ? (float)flushes / calls : 0.0,
+							calls ? (float)usb / calls : 0.0);
+
+					/* keep going, a failing combination is a result too */
+					retval = ERROR_OK;
+					keep_alive();
+				}
+			}
+		}
+	}
+
+	free(buffer);
+	target_free_working_area(target, wa);
+	free(parsed_lengths);
+
+	return retval;
+}
+
+static int bench_target_read_memory(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	return target_read_memory(priv, address, size, count, buffer);
+}
+
+static int bench_target_write_memory(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, const uint8_t *buffer)
+{
+	return target_write_memory(priv, address, size, count, buffer);
+}
+
+static int bench_target_read_buffer(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, uint8_t *buffer)
+{
+	return target_read_buffer(priv, address, size * count, buffer);
+}
+
+static int bench_target_write_buffer(void *priv, target_addr_t address,
+		uint32_t size, uint32_t count, const uint8_t *buffer)
+{
+	return target_write_buffer(priv, address, size * count, buffer);
+}
+
+COMMAND_HANDLER(handle_bench_mem_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct target_bench_mem_ops ops = {
+		.name = "memory",
+		.read = bench_target_read_memory,
+		.write = bench_target_write_memory,
+		.priv = target,
+	};
+
+	return target_bench_mem(CMD_CTX, target, &ops, CMD_ARGC, CMD_ARGV);
+}
+
+COMMAND_HANDLER(handle_bench_buffer_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct target_bench_mem_ops ops = {
+		.name = "buffer",
+		.read = bench_target_read_buffer,
+		.write = bench_target_write_buffer,
+		.priv = target,
+		.bytes_only = true,
+	};
+
+	return target_bench_mem(CMD_CTX, target, &ops, CMD_ARGC, CMD_ARGV);
+}
+
+static const struct command_registration bench_command_handlers[] = {
+	{
+		.name = "mem",
+		.handler = handle_bench_mem_command,
+		.mode = COMMAND_EXEC,
+		.help = "time target_read_memory/target_write_memory for each "
+			"access size, alignment and length, output is CSV",
+		.usage = "['read'|'write'] [length ...]",
+	},
+	{
+		.name = "buffer",
+		.handler = handle_bench_buffer_command,
+		.mode = COMMAND_EXEC,
+		.help = "time target_read_buffer/target_write_buffer for each "
+			"alignment and length, output is CSV",
+		.usage = "['read'|'write'] [length ...]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
 static const struct command_registration target_exec_command_handlers[] = {
 	{
 		.name = "fast_load_image",
@@ -6410,6 +6658,13 @@ static const struct command_registration target_exec_command_handlers[] = {
 		.help = "Test the target's memory access functions",
 		.usage = "size",
 	},
+	{
+		.name = "bench",
+		.mode = COMMAND_ANY,
+		.help = "memory access benchmarks",
+		.usage = "",
+		.chain = bench_command_handlers,
+	},
 
 	COMMAND_REGISTRATION_DONE
 };
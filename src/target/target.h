@@ -204,6 +204,10 @@ struct target {
 
 	/* file-I/O information for host to do syscall */
 	struct gdb_fileio_info *fileio_info;
+
+	/* incremented by every memory write through the target API, lets
+	 * copies of target memory kept elsewhere tell when they are stale */
+	uint32_t memory_write_count;
 };
 
 struct target_list {
@@ -378,6 +382,11 @@ int target_call_timer_callbacks(void);
  * a synchronous command completes.
  */
 int target_call_timer_callbacks_now(void);
+/**
+ * Returns the number of milliseconds until the next timer callback is due,
+ * 0 if one is due already, or -1 if none are registered.
+ */
+int target_timer_next_event(void);
 
 struct target *get_target_by_num(int num);
 struct target *get_current_target(struct command_context *cmd_ctx);
@@ -681,6 +690,28 @@ int target_write_phys_u8(struct target *target, target_addr_t address, uint8_t v
 /* Issues USER() statements with target state information */
 int target_arch_state(struct target *target);
 
+/** Memory access functions measured by target_bench_mem(). */
+struct target_bench_mem_ops {
+	const char *name;
+	int (*read)(void *priv, target_addr_t address,
+			uint32_t size, uint32_t count, uint8_t *buffer);
+	int (*write)(void *priv, target_addr_t address,
+			uint32_t size, uint32_t count, const uint8_t *buffer);
+	void *priv;
+	/* read and write take a byte count, the access size isn't swept */
+	bool bytes_only;
+};
+
+/**
+ * Implements the "bench mem" family of commands: times @a ops for every
+ * direction, access size (unless @a ops is bytes_only), alignment and
+ * transfer length selected by the
+ * command arguments "['read'|'write'] [length ...]", in the target's
+ * working area, and prints one CSV line per combination.
+ */
+int target_bench_mem(struct command_context *cmd_ctx, struct target *target,
+		const struct target_bench_mem_ops *ops, unsigned argc, const char **argv);
+
 void target_handle_event(struct target *t, enum target_event e);
 
 #define ERROR_TARGET_INVALID	(-300)